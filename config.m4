@@ -110,6 +110,8 @@ if test "$PHP_MONGODB" != "no"; then
     src/BSON/DBPointer.c \
     src/BSON/Decimal128.c \
     src/BSON/Decimal128Interface.c \
+    src/BSON/Document.c \
+    src/BSON/Hydratable.c \
     src/BSON/Int64.c \
     src/BSON/Javascript.c \
     src/BSON/JavascriptInterface.c \
@@ -141,6 +143,7 @@ if test "$PHP_MONGODB" != "no"; then
     src/MongoDB/Query.c \
     src/MongoDB/ReadConcern.c \
     src/MongoDB/ReadPreference.c \
+    src/MongoDB/RecordSet.c \
     src/MongoDB/Server.c \
     src/MongoDB/Session.c \
     src/MongoDB/WriteConcern.c \
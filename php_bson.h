@@ -24,6 +24,7 @@
 
 #define BSON_UNSERIALIZE_FUNC_NAME "bsonUnserialize"
 #define BSON_SERIALIZE_FUNC_NAME "bsonSerialize"
+#define BSON_FIELD_MAP_FUNC_NAME "bsonFieldMap"
 
 #define PHONGO_ODM_FIELD_NAME "__pclass"
 
@@ -37,9 +38,22 @@ typedef enum {
 	PHONGO_TYPEMAP_NONE,
 	PHONGO_TYPEMAP_NATIVE_ARRAY,
 	PHONGO_TYPEMAP_NATIVE_OBJECT,
-	PHONGO_TYPEMAP_CLASS
+	PHONGO_TYPEMAP_CLASS,
+	PHONGO_TYPEMAP_BSON,
+	PHONGO_TYPEMAP_HYDRATE
 } php_phongo_bson_typemap_types;
 
+/* Native representations for leaf BSON types, as selected by the "types" type
+ * map key. PHONGO_TYPEMAP_LEAF_DEFAULT decodes to the BSON type classes (or a
+ * PHP integer for int64). */
+typedef enum {
+	PHONGO_TYPEMAP_LEAF_DEFAULT,
+	PHONGO_TYPEMAP_LEAF_STRING,
+	PHONGO_TYPEMAP_LEAF_BINARY,
+	PHONGO_TYPEMAP_LEAF_INT,
+	PHONGO_TYPEMAP_LEAF_DATETIME
+} php_phongo_bson_typemap_leaf_types;
+
 typedef enum {
 	PHONGO_FIELD_PATH_ITEM_NONE,
 	PHONGO_FIELD_PATH_ITEM_ARRAY,
@@ -55,32 +69,52 @@ typedef struct {
 	bool                                   owns_elements;
 } php_phongo_field_path;
 
-typedef struct _php_phongo_field_path_map_element {
-	php_phongo_field_path*        entry;
-	php_phongo_bson_typemap_types node_type;
-	zend_class_entry*             node_ce;
-} php_phongo_field_path_map_element;
+/* Node of the trie compiled from the fieldPaths type map key. Each node
+ * represents one path segment ("$" matches any key); node_type is
+ * PHONGO_TYPEMAP_NONE for intermediate nodes. The order field records when the
+ * field path was registered, so that the first matching path takes precedence
+ * if wildcards allow several to match. */
+typedef struct _php_phongo_field_path_node {
+	char*                               name;
+	php_phongo_bson_typemap_types       node_type;
+	zend_class_entry*                   node_ce;
+	size_t                              order;
+	struct _php_phongo_field_path_node* children;
+	struct _php_phongo_field_path_node* next;
+} php_phongo_field_path_node;
 
 typedef struct {
-	php_phongo_bson_typemap_types document_type;
-	zend_class_entry*             document;
-	php_phongo_bson_typemap_types array_type;
-	zend_class_entry*             array;
-	php_phongo_bson_typemap_types root_type;
-	zend_class_entry*             root;
-	struct {
-		php_phongo_field_path_map_element** map;
-		size_t                              allocated_size;
-		size_t                              size;
-	} field_paths;
+	php_phongo_bson_typemap_types      document_type;
+	zend_class_entry*                  document;
+	php_phongo_bson_typemap_types      array_type;
+	zend_class_entry*                  array;
+	php_phongo_bson_typemap_types      root_type;
+	zend_class_entry*                  root;
+	php_phongo_field_path_node         field_path_map;
+	size_t                             field_path_count;
+	bool                               vector_as_array;
+	php_phongo_bson_typemap_leaf_types objectid_type;
+	php_phongo_bson_typemap_leaf_types utcdatetime_type;
+	php_phongo_bson_typemap_leaf_types decimal128_type;
+	php_phongo_bson_typemap_leaf_types int64_type;
+	php_phongo_field_path_node         projection_map;
 } php_phongo_bson_typemap;
 
 typedef struct {
-	ZVAL_RETVAL_TYPE        zchild;
-	php_phongo_bson_typemap map;
-	zend_class_entry*       odm;
-	bool                    is_visiting_array;
-	php_phongo_field_path*  field_path;
+	ZVAL_RETVAL_TYPE             zchild;
+	php_phongo_bson_typemap      map;
+	zend_class_entry*            odm;
+	bool                         is_visiting_array;
+	php_phongo_field_path*       field_path;
+	php_phongo_field_path_node** field_path_nodes;
+	size_t                       field_path_nodes_count;
+	HashTable*                   key_cache;
+	HashTable*                   hydrate_plan;
+	zend_class_entry*            hydrate_ce;
+	php_phongo_field_path_node*  projection;
+	bool                         projection_in_array;
+	HashTable*                   recycle_ht;
+	uint32_t                     recycle_pos;
 } php_phongo_bson_state;
 
 #if PHP_VERSION_ID >= 70000
@@ -97,6 +131,7 @@ typedef struct {
 
 void php_phongo_zval_to_bson(zval* data, php_phongo_bson_flags_t flags, bson_t* bson, bson_t** bson_out TSRMLS_DC);
 bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_phongo_bson_state* state);
+bool php_phongo_bson_to_zval_recycle(const unsigned char* data, int data_len, php_phongo_bson_state* state);
 #if PHP_VERSION_ID >= 70000
 bool php_phongo_bson_to_zval(const unsigned char* data, int data_len, zval* out);
 #else
@@ -106,7 +141,10 @@ bool php_phongo_bson_typemap_to_state(zval* typemap, php_phongo_bson_typemap* ma
 void php_phongo_bson_state_ctor(php_phongo_bson_state* state);
 void php_phongo_bson_state_dtor(php_phongo_bson_state* state);
 void php_phongo_bson_state_copy_ctor(php_phongo_bson_state* dst, php_phongo_bson_state* src);
+void php_phongo_bson_state_key_cache_ctor(php_phongo_bson_state* state);
+void php_phongo_bson_state_key_cache_dtor(php_phongo_bson_state* state);
 void php_phongo_bson_typemap_dtor(php_phongo_bson_typemap* map);
+bool php_phongo_bson_utf8_validate(const char* str, size_t len, bool allow_null);
 
 php_phongo_field_path* php_phongo_field_path_alloc(bool owns_elements);
 void                   php_phongo_field_path_free(php_phongo_field_path* field_path);
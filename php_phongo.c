@@ -299,6 +299,9 @@ static void phongo_cursor_init(zval* return_value, mongoc_client_t* client, mong
 	intern->client    = client;
 	intern->advanced  = false;
 
+	/* Documents in a result set typically share field names */
+	php_phongo_bson_state_key_cache_ctor(&intern->visitor_data);
+
 	if (readPreference) {
 #if PHP_VERSION_ID >= 70000
 		ZVAL_ZVAL(&intern->read_preference, readPreference, 1, 0);
@@ -804,6 +807,131 @@ bool phongo_cursor_advance_and_check_for_error(mongoc_cursor_t* cursor TSRMLS_DC
 	return true;
 } /* }}} */
 
+/* Detached cursors are retained for the server's default cursor timeout, after
+ * which the server will have closed any that were never attached */
+#define PHONGO_PCURSOR_TTL 600
+
+#if PHP_VERSION_ID >= 70000
+static int php_phongo_pcursor_expire(zval* zv, void* arg) /* {{{ */
+{
+	php_phongo_pcursor_t* pcursor = (php_phongo_pcursor_t*) Z_PTR_P(zv);
+#else
+static int php_phongo_pcursor_expire(void* pp, void* arg TSRMLS_DC) /* {{{ */
+{
+	php_phongo_pcursor_t* pcursor = *((php_phongo_pcursor_t**) pp);
+#endif
+
+	if (*((time_t*) arg) - pcursor->detached_at >= PHONGO_PCURSOR_TTL) {
+		return ZEND_HASH_APPLY_REMOVE;
+	}
+
+	return ZEND_HASH_APPLY_KEEP;
+} /* }}} */
+
+/* Moves a Cursor's libmongoc cursor into the persistent cursor registry, where
+ * it can be attached to a new Cursor by a later request in this process. The
+ * libmongoc cursor retains its buffered documents and implicit session, and is
+ * only valid for the persistent client that created it. */
+void phongo_cursor_detach(php_phongo_cursor_t* cursor, const char* token TSRMLS_DC) /* {{{ */
+{
+	php_phongo_pcursor_t* pcursor = (php_phongo_pcursor_t*) pecalloc(1, sizeof(php_phongo_pcursor_t), 1);
+	time_t                now     = time(NULL);
+
+	zend_hash_apply_with_argument(&MONGODB_G(pcursors), php_phongo_pcursor_expire, &now TSRMLS_CC);
+
+	pcursor->pid         = (int) getpid();
+	pcursor->cursor      = cursor->cursor;
+	pcursor->client      = cursor->client;
+	pcursor->advanced    = cursor->advanced;
+	pcursor->detached_at = now;
+
+	/* The libmongoc cursor's current document has already been returned if
+	 * the Cursor was iterated, unless nextBatch() held it back */
+	pcursor->consumed_current = cursor->got_batch ? cursor->consumed_current : cursor->got_iterator;
+
+	if (cursor->database) {
+		pcursor->database = pestrdup(cursor->database, 1);
+	}
+
+	if (cursor->collection) {
+		pcursor->collection = pestrdup(cursor->collection, 1);
+	}
+
+#if PHP_VERSION_ID >= 70000
+	zend_hash_str_update_ptr(&MONGODB_G(pcursors), token, strlen(token), pcursor);
+#else
+	zend_hash_update(&MONGODB_G(pcursors), token, strlen(token) + 1, &pcursor, sizeof(php_phongo_pcursor_t*), NULL);
+#endif
+
+	cursor->cursor = NULL;
+} /* }}} */
+
+/* Initializes a Cursor with the libmongoc cursor detached under the given
+ * token, removing it from the persistent cursor registry. Returns false and
+ * throws if no cursor was detached from this client under the token. */
+bool phongo_cursor_attach(zval* return_value, mongoc_client_t* client, const char* token, size_t token_len TSRMLS_DC) /* {{{ */
+{
+	php_phongo_pcursor_t* pcursor = NULL;
+	php_phongo_cursor_t*  intern;
+	bool                  consumed_current;
+
+#if PHP_VERSION_ID >= 70000
+	pcursor = zend_hash_str_find_ptr(&MONGODB_G(pcursors), token, token_len);
+#else
+	{
+		php_phongo_pcursor_t** ppcursor;
+
+		if (zend_hash_find(&MONGODB_G(pcursors), token, token_len + 1, (void**) &ppcursor) == SUCCESS) {
+			pcursor = *ppcursor;
+		}
+	}
+#endif
+
+	if (!pcursor || pcursor->pid != (int) getpid()) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "No detached cursor exists for token \"%s\"", token);
+		return false;
+	}
+
+	if (pcursor->client != client) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "The cursor for token \"%s\" was detached from a different Manager", token);
+		return false;
+	}
+
+	phongo_cursor_init(return_value, client, pcursor->cursor, NULL, NULL TSRMLS_CC);
+
+	intern           = Z_CURSOR_OBJ_P(return_value);
+	intern->advanced = pcursor->advanced;
+	consumed_current = pcursor->consumed_current;
+
+	if (pcursor->database) {
+		intern->database = estrdup(pcursor->database);
+	}
+
+	if (pcursor->collection) {
+		intern->collection = estrdup(pcursor->collection);
+	}
+
+	/* The libmongoc cursor now belongs to the Cursor, so it must not be
+	 * destroyed along with the registry entry */
+	pcursor->cursor = NULL;
+
+#if PHP_VERSION_ID >= 70000
+	zend_hash_str_del(&MONGODB_G(pcursors), token, token_len);
+#else
+	zend_hash_del(&MONGODB_G(pcursors), token, token_len + 1);
+#endif
+
+	/* Skip a document that was already returned before the cursor was detached */
+	if (intern->advanced && consumed_current && !phongo_cursor_advance_and_check_for_error(intern->cursor TSRMLS_CC)) {
+		/* Exception should already have been thrown */
+		zval_dtor(return_value);
+		ZVAL_NULL(return_value);
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
 bool phongo_execute_query(mongoc_client_t* client, const char* namespace, zval* zquery, zval* options, uint32_t server_id, zval* return_value, int return_value_used TSRMLS_DC) /* {{{ */
 {
 	const php_phongo_query_t* query;
@@ -2238,6 +2366,14 @@ static void php_phongo_command_succeeded(const mongoc_apm_command_succeeded_t* e
 #endif
 	TSRMLS_FETCH();
 
+	/* Count getMore replies so that Cursor::nextBatch() can detect when
+	 * advancing a cursor has fetched a new batch from the server. Replies are
+	 * counted instead of commands, since libmongoc reports each batch streamed
+	 * by an exhaust cursor as a succeeded getMore without a started event. */
+	if (!strcmp(mongoc_apm_command_succeeded_get_command_name(event), "getMore")) {
+		MONGODB_G(getmore_count)++;
+	}
+
 	/* Return early if there are no APM subscribers to notify */
 	if (!MONGODB_G(subscribers) || zend_hash_num_elements(MONGODB_G(subscribers)) == 0) {
 		return;
@@ -2642,6 +2778,16 @@ void php_phongo_new_decimal128(zval* object, const bson_decimal128_t* decimal TS
 	intern->initialized = true;
 } /* }}} */
 
+void php_phongo_new_document_from_bson(zval* object, const uint8_t* data, size_t data_len TSRMLS_DC) /* {{{ */
+{
+	php_phongo_document_t* intern;
+
+	object_init_ex(object, php_phongo_document_ce);
+
+	intern       = Z_DOCUMENT_OBJ_P(object);
+	intern->bson = bson_new_from_data(data, data_len);
+} /* }}} */
+
 void php_phongo_new_int64(zval* object, int64_t integer TSRMLS_DC) /* {{{ */
 {
 	php_phongo_int64_t* intern;
@@ -2836,6 +2982,38 @@ static void php_phongo_pclient_dtor(void* pp)
 }
 #endif
 
+static inline void php_phongo_pcursor_destroy(php_phongo_pcursor_t* pcursor)
+{
+	/* As with persistent clients, do not destroy mongoc_cursor_t objects
+	 * created by other processes. The cursor will be NULL if it was attached
+	 * to a Cursor object. */
+	if (pcursor->cursor && pcursor->pid == getpid()) {
+		mongoc_cursor_destroy(pcursor->cursor);
+	}
+
+	if (pcursor->database) {
+		pefree(pcursor->database, 1);
+	}
+
+	if (pcursor->collection) {
+		pefree(pcursor->collection, 1);
+	}
+
+	pefree(pcursor, 1);
+}
+
+#if PHP_VERSION_ID >= 70000
+static void php_phongo_pcursor_dtor(zval* zv)
+{
+	php_phongo_pcursor_destroy((php_phongo_pcursor_t*) Z_PTR_P(zv));
+}
+#else
+static void php_phongo_pcursor_dtor(void* pp)
+{
+	php_phongo_pcursor_destroy(*((php_phongo_pcursor_t**) pp));
+}
+#endif
+
 /* {{{ PHP_RINIT_FUNCTION */
 PHP_RINIT_FUNCTION(mongodb)
 {
@@ -2869,6 +3047,9 @@ PHP_GINIT_FUNCTION(mongodb)
 
 	/* Initialize HashTable for persistent clients */
 	zend_hash_init_ex(&mongodb_globals->pclients, 0, NULL, php_phongo_pclient_dtor, 1, 0);
+
+	/* Initialize HashTable for cursors detached from previous requests */
+	zend_hash_init_ex(&mongodb_globals->pcursors, 0, NULL, php_phongo_pcursor_dtor, 1, 0);
 }
 /* }}} */
 
@@ -2946,6 +3127,7 @@ PHP_MINIT_FUNCTION(mongodb)
 	php_phongo_type_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_serializable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_unserializable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_hydratable_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 
 	php_phongo_binary_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_decimal128_interface_init_ce(INIT_FUNC_ARGS_PASSTHRU);
@@ -2960,6 +3142,7 @@ PHP_MINIT_FUNCTION(mongodb)
 	php_phongo_binary_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_dbpointer_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_decimal128_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_document_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_int64_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_javascript_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_maxkey_init_ce(INIT_FUNC_ARGS_PASSTHRU);
@@ -2982,6 +3165,7 @@ PHP_MINIT_FUNCTION(mongodb)
 	php_phongo_query_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_readconcern_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_readpreference_init_ce(INIT_FUNC_ARGS_PASSTHRU);
+	php_phongo_recordset_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_server_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_session_init_ce(INIT_FUNC_ARGS_PASSTHRU);
 	php_phongo_writeconcern_init_ce(INIT_FUNC_ARGS_PASSTHRU);
@@ -3025,6 +3209,10 @@ PHP_MSHUTDOWN_FUNCTION(mongodb)
 {
 	(void) type; /* We don't care if we are loaded via dl() or extension= */
 
+	/* Destroy HashTable for detached cursors before their clients are
+	 * destroyed below */
+	zend_hash_destroy(&MONGODB_G(pcursors));
+
 	/* Destroy HashTable for persistent clients. The HashTable destructor will
 	 * destroy any mongoc_client_t objects that were created by this process. */
 	zend_hash_destroy(&MONGODB_G(pclients));
@@ -3049,6 +3237,22 @@ PHP_RSHUTDOWN_FUNCTION(mongodb)
 		MONGODB_G(subscribers) = NULL;
 	}
 
+	/* Destroy HashTable for classes resolved during BSON decoding, which is
+	 * initialized on first use */
+	if (MONGODB_G(class_cache)) {
+		zend_hash_destroy(MONGODB_G(class_cache));
+		FREE_HASHTABLE(MONGODB_G(class_cache));
+		MONGODB_G(class_cache) = NULL;
+	}
+
+	/* Destroy HashTable for class descriptors used during BSON encoding, which
+	 * is initialized on first use */
+	if (MONGODB_G(encode_class_cache)) {
+		zend_hash_destroy(MONGODB_G(encode_class_cache));
+		FREE_HASHTABLE(MONGODB_G(encode_class_cache));
+		MONGODB_G(encode_class_cache) = NULL;
+	}
+
 	return SUCCESS;
 }
 /* }}} */
@@ -36,12 +36,27 @@ typedef struct {
 	int              pid;
 } php_phongo_pclient_t;
 
+typedef struct {
+	mongoc_cursor_t* cursor;
+	mongoc_client_t* client;
+	char*            database;
+	char*            collection;
+	bool             advanced;
+	bool             consumed_current;
+	time_t           detached_at;
+	int              pid;
+} php_phongo_pcursor_t;
+
 ZEND_BEGIN_MODULE_GLOBALS(mongodb)
 	char*             debug;
 	FILE*             debug_fd;
 	bson_mem_vtable_t bsonMemVTable;
 	HashTable         pclients;
+	HashTable         pcursors;
 	HashTable*        subscribers;
+	HashTable*        class_cache;
+	HashTable*        encode_class_cache;
+	uint32_t          getmore_count;
 ZEND_END_MODULE_GLOBALS(mongodb)
 
 #if PHP_VERSION_ID >= 70000
@@ -139,6 +154,8 @@ bool phongo_execute_command(mongoc_client_t* client, php_phongo_command_type_t t
 bool phongo_execute_query(mongoc_client_t* client, const char* namespace, zval* zquery, zval* zreadPreference, uint32_t server_id, zval* return_value, int return_value_used TSRMLS_DC);
 
 bool phongo_cursor_advance_and_check_for_error(mongoc_cursor_t* cursor TSRMLS_DC);
+void phongo_cursor_detach(php_phongo_cursor_t* cursor, const char* token TSRMLS_DC);
+bool phongo_cursor_attach(zval* return_value, mongoc_client_t* client, const char* token, size_t token_len TSRMLS_DC);
 
 const mongoc_read_concern_t*  phongo_read_concern_from_zval(zval* zread_concern TSRMLS_DC);
 const mongoc_read_prefs_t*    phongo_read_preference_from_zval(zval* zread_preference TSRMLS_DC);
@@ -159,16 +176,28 @@ void php_phongo_read_concern_to_zval(zval* retval, const mongoc_read_concern_t*
 void php_phongo_write_concern_to_zval(zval* retval, const mongoc_write_concern_t* write_concern);
 void php_phongo_cursor_to_zval(zval* retval, const mongoc_cursor_t* cursor);
 
+/* Vector binary subtype and its dtype bytes, which the bundled libbson does not
+ * define. The first byte of a vector's payload is the dtype and the second is
+ * the number of padding bits in the final byte (only used for PACKED_BIT). */
+#define PHONGO_BINARY_SUBTYPE_VECTOR 0x09
+#define PHONGO_BINARY_VECTOR_INT8 0x03
+#define PHONGO_BINARY_VECTOR_FLOAT32 0x27
+#define PHONGO_BINARY_VECTOR_PACKED_BIT 0x10
+
 void phongo_manager_init(php_phongo_manager_t* manager, const char* uri_string, zval* options, zval* driverOptions TSRMLS_DC);
 int  php_phongo_set_monitoring_callbacks(mongoc_client_t* client);
 void php_phongo_objectid_new_from_oid(zval* object, const bson_oid_t* oid TSRMLS_DC);
 void php_phongo_cursor_id_new_from_id(zval* object, int64_t cursorid TSRMLS_DC);
+void php_phongo_recordset_init(zval* object, uint8_t* data, size_t* offsets, uint32_t count, php_phongo_bson_typemap* map, HashTable* key_cache, uint32_t cache_size TSRMLS_DC);
 void php_phongo_new_utcdatetime_from_epoch(zval* object, int64_t msec_since_epoch TSRMLS_DC);
+void php_phongo_new_datetime_from_epoch(zval* object, int64_t msec_since_epoch, zend_class_entry* ce TSRMLS_DC);
 void php_phongo_new_timestamp_from_increment_and_timestamp(zval* object, uint32_t increment, uint32_t timestamp TSRMLS_DC);
 void php_phongo_new_javascript_from_javascript(int init, zval* object, const char* code, size_t code_len TSRMLS_DC);
 void php_phongo_new_javascript_from_javascript_and_scope(int init, zval* object, const char* code, size_t code_len, const bson_t* scope TSRMLS_DC);
 void php_phongo_new_binary_from_binary_and_type(zval* object, const char* data, size_t data_len, bson_subtype_t type TSRMLS_DC);
+bool php_phongo_binary_vector_to_zval(const uint8_t* data, size_t data_len, zval* out TSRMLS_DC);
 void php_phongo_new_decimal128(zval* object, const bson_decimal128_t* decimal TSRMLS_DC);
+void php_phongo_new_document_from_bson(zval* object, const uint8_t* data, size_t data_len TSRMLS_DC);
 void php_phongo_new_int64(zval* object, int64_t integer TSRMLS_DC);
 void php_phongo_new_regex_from_regex_and_options(zval* object, const char* pattern, const char* flags TSRMLS_DC);
 void php_phongo_new_symbol(zval* object, const char* symbol, size_t symbol_len TSRMLS_DC);
@@ -57,6 +57,10 @@ static inline php_phongo_readpreference_t* php_readpreference_fetch_object(zend_
 {
 	return (php_phongo_readpreference_t*) ((char*) obj - XtOffsetOf(php_phongo_readpreference_t, std));
 }
+static inline php_phongo_recordset_t* php_recordset_fetch_object(zend_object* obj)
+{
+	return (php_phongo_recordset_t*) ((char*) obj - XtOffsetOf(php_phongo_recordset_t, std));
+}
 static inline php_phongo_server_t* php_server_fetch_object(zend_object* obj)
 {
 	return (php_phongo_server_t*) ((char*) obj - XtOffsetOf(php_phongo_server_t, std));
@@ -93,6 +97,10 @@ static inline php_phongo_decimal128_t* php_decimal128_fetch_object(zend_object*
 {
 	return (php_phongo_decimal128_t*) ((char*) obj - XtOffsetOf(php_phongo_decimal128_t, std));
 }
+static inline php_phongo_document_t* php_document_fetch_object(zend_object* obj)
+{
+	return (php_phongo_document_t*) ((char*) obj - XtOffsetOf(php_phongo_document_t, std));
+}
 static inline php_phongo_int64_t* php_int64_fetch_object(zend_object* obj)
 {
 	return (php_phongo_int64_t*) ((char*) obj - XtOffsetOf(php_phongo_int64_t, std));
@@ -153,6 +161,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_QUERY_OBJ_P(zv) (php_query_fetch_object(Z_OBJ_P(zv)))
 #define Z_READCONCERN_OBJ_P(zv) (php_readconcern_fetch_object(Z_OBJ_P(zv)))
 #define Z_READPREFERENCE_OBJ_P(zv) (php_readpreference_fetch_object(Z_OBJ_P(zv)))
+#define Z_RECORDSET_OBJ_P(zv) (php_recordset_fetch_object(Z_OBJ_P(zv)))
 #define Z_SERVER_OBJ_P(zv) (php_server_fetch_object(Z_OBJ_P(zv)))
 #define Z_SESSION_OBJ_P(zv) (php_session_fetch_object(Z_OBJ_P(zv)))
 #define Z_BULKWRITE_OBJ_P(zv) (php_bulkwrite_fetch_object(Z_OBJ_P(zv)))
@@ -163,6 +172,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_BINARY_OBJ_P(zv) (php_binary_fetch_object(Z_OBJ_P(zv)))
 #define Z_DBPOINTER_OBJ_P(zv) (php_dbpointer_fetch_object(Z_OBJ_P(zv)))
 #define Z_DECIMAL128_OBJ_P(zv) (php_decimal128_fetch_object(Z_OBJ_P(zv)))
+#define Z_DOCUMENT_OBJ_P(zv) (php_document_fetch_object(Z_OBJ_P(zv)))
 #define Z_INT64_OBJ_P(zv) (php_int64_fetch_object(Z_OBJ_P(zv)))
 #define Z_JAVASCRIPT_OBJ_P(zv) (php_javascript_fetch_object(Z_OBJ_P(zv)))
 #define Z_MAXKEY_OBJ_P(zv) (php_maxkey_fetch_object(Z_OBJ_P(zv)))
@@ -184,6 +194,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_OBJ_QUERY(zo) (php_query_fetch_object(zo))
 #define Z_OBJ_READCONCERN(zo) (php_readconcern_fetch_object(zo))
 #define Z_OBJ_READPREFERENCE(zo) (php_readpreference_fetch_object(zo))
+#define Z_OBJ_RECORDSET(zo) (php_recordset_fetch_object(zo))
 #define Z_OBJ_SERVER(zo) (php_server_fetch_object(zo))
 #define Z_OBJ_SESSION(zo) (php_session_fetch_object(zo))
 #define Z_OBJ_BULKWRITE(zo) (php_bulkwrite_fetch_object(zo))
@@ -194,6 +205,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_OBJ_BINARY(zo) (php_binary_fetch_object(zo))
 #define Z_OBJ_DBPOINTER(zo) (php_dbpointer_fetch_object(zo))
 #define Z_OBJ_DECIMAL128(zo) (php_decimal128_fetch_object(zo))
+#define Z_OBJ_DOCUMENT(zo) (php_document_fetch_object(zo))
 #define Z_OBJ_INT64(zo) (php_int64_fetch_object(zo))
 #define Z_OBJ_JAVASCRIPT(zo) (php_javascript_fetch_object(zo))
 #define Z_OBJ_MAXKEY(zo) (php_maxkey_fetch_object(zo))
@@ -217,6 +229,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_QUERY_OBJ_P(zv) ((php_phongo_query_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_READCONCERN_OBJ_P(zv) ((php_phongo_readconcern_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_READPREFERENCE_OBJ_P(zv) ((php_phongo_readpreference_t*) zend_object_store_get_object(zv TSRMLS_CC))
+#define Z_RECORDSET_OBJ_P(zv) ((php_phongo_recordset_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_SERVER_OBJ_P(zv) ((php_phongo_server_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_SESSION_OBJ_P(zv) ((php_phongo_session_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_BULKWRITE_OBJ_P(zv) ((php_phongo_bulkwrite_t*) zend_object_store_get_object(zv TSRMLS_CC))
@@ -227,6 +240,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_BINARY_OBJ_P(zv) ((php_phongo_binary_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_DBPOINTER_OBJ_P(zv) ((php_phongo_dbpointer_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_DECIMAL128_OBJ_P(zv) ((php_phongo_decimal128_t*) zend_object_store_get_object(zv TSRMLS_CC))
+#define Z_DOCUMENT_OBJ_P(zv) ((php_phongo_document_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_INT64_OBJ_P(zv) ((php_phongo_int64_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_JAVASCRIPT_OBJ_P(zv) ((php_phongo_javascript_t*) zend_object_store_get_object(zv TSRMLS_CC))
 #define Z_MAXKEY_OBJ_P(zv) ((php_phongo_maxkey_t*) zend_object_store_get_object(zv TSRMLS_CC))
@@ -248,6 +262,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_OBJ_QUERY(zo) ((php_phongo_query_t*) zo)
 #define Z_OBJ_READCONCERN(zo) ((php_phongo_readconcern_t*) zo)
 #define Z_OBJ_READPREFERENCE(zo) ((php_phongo_readpreference_t*) zo)
+#define Z_OBJ_RECORDSET(zo) ((php_phongo_recordset_t*) zo)
 #define Z_OBJ_SERVER(zo) ((php_phongo_server_t*) zo)
 #define Z_OBJ_SESSION(zo) ((php_phongo_session_t*) zo)
 #define Z_OBJ_BULKWRITE(zo) ((php_phongo_bulkwrite_t*) zo)
@@ -258,6 +273,7 @@ static inline php_phongo_commandsucceededevent_t* php_commandsucceededevent_fetc
 #define Z_OBJ_BINARY(zo) ((php_phongo_binary_t*) zo)
 #define Z_OBJ_DBPOINTER(zo) ((php_phongo_dbpointer_t*) zo)
 #define Z_OBJ_DECIMAL128(zo) ((php_phongo_decimal128_t*) zo)
+#define Z_OBJ_DOCUMENT(zo) ((php_phongo_document_t*) zo)
 #define Z_OBJ_INT64(zo) ((php_phongo_int64_t*) zo)
 #define Z_OBJ_JAVASCRIPT(zo) ((php_phongo_javascript_t*) zo)
 #define Z_OBJ_MAXKEY(zo) ((php_phongo_maxkey_t*) zo)
@@ -279,6 +295,22 @@ typedef struct {
 	php_phongo_cursor_t* cursor;
 } php_phongo_cursor_iterator;
 
+typedef struct {
+	zend_object_iterator    intern;
+	php_phongo_recordset_t* recordset;
+	uint32_t                position;
+	PHONGO_STRUCT_ZVAL      current;
+} php_phongo_recordset_iterator;
+
+/* Returns the BSON data of a Document. A Document whose initialization failed
+ * (e.g. in unserialize()) has no data and behaves as an empty document. */
+static inline const bson_t* php_phongo_document_get_bson(php_phongo_document_t* intern)
+{
+	static const bson_t empty = BSON_INITIALIZER;
+
+	return intern->bson ? intern->bson : &empty;
+}
+
 extern zend_class_entry* php_phongo_command_ce;
 extern zend_class_entry* php_phongo_cursor_ce;
 extern zend_class_entry* php_phongo_cursorid_ce;
@@ -286,6 +318,7 @@ extern zend_class_entry* php_phongo_manager_ce;
 extern zend_class_entry* php_phongo_query_ce;
 extern zend_class_entry* php_phongo_readconcern_ce;
 extern zend_class_entry* php_phongo_readpreference_ce;
+extern zend_class_entry* php_phongo_recordset_ce;
 extern zend_class_entry* php_phongo_server_ce;
 extern zend_class_entry* php_phongo_session_ce;
 extern zend_class_entry* php_phongo_bulkwrite_ce;
@@ -313,11 +346,13 @@ extern zend_class_entry* php_phongo_bulkwriteexception_ce;
 
 extern zend_class_entry* php_phongo_type_ce;
 extern zend_class_entry* php_phongo_persistable_ce;
+extern zend_class_entry* php_phongo_hydratable_ce;
 extern zend_class_entry* php_phongo_unserializable_ce;
 extern zend_class_entry* php_phongo_serializable_ce;
 extern zend_class_entry* php_phongo_binary_ce;
 extern zend_class_entry* php_phongo_dbpointer_ce;
 extern zend_class_entry* php_phongo_decimal128_ce;
+extern zend_class_entry* php_phongo_document_ce;
 extern zend_class_entry* php_phongo_int64_ce;
 extern zend_class_entry* php_phongo_javascript_ce;
 extern zend_class_entry* php_phongo_maxkey_ce;
@@ -348,6 +383,7 @@ extern zend_class_entry* php_phongo_subscriber_ce;
 extern void php_phongo_binary_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_dbpointer_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_decimal128_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_document_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_int64_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_javascript_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_maxkey_init_ce(INIT_FUNC_ARGS);
@@ -360,6 +396,7 @@ extern void php_phongo_symbol_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_timestamp_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_type_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_undefined_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_hydratable_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_unserializable_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_utcdatetime_init_ce(INIT_FUNC_ARGS);
 
@@ -381,6 +418,7 @@ extern void php_phongo_manager_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_query_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_readconcern_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_readpreference_init_ce(INIT_FUNC_ARGS);
+extern void php_phongo_recordset_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_server_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_session_init_ce(INIT_FUNC_ARGS);
 extern void php_phongo_writeconcern_init_ce(INIT_FUNC_ARGS);
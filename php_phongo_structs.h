@@ -59,6 +59,20 @@ typedef struct {
 	bool                  advanced;
 	php_phongo_bson_state visitor_data;
 	bool                  got_iterator;
+	bool                  recycle_documents;
+	bool                  got_batch;
+	bool                  consumed_current;
+	uint32_t              adaptive_batch_bytes;
+	uint32_t              adaptive_batch_size;
+	uint64_t              observed_bytes;
+	uint64_t              observed_count;
+	bool                  replayable;
+	bool                  replaying;
+	uint8_t*              replay_buffer;
+	size_t                replay_len;
+	size_t                replay_alloc;
+	size_t                replay_pos;
+	char*                 detach_token;
 	long                  current;
 	char*                 database;
 	char*                 collection;
@@ -104,6 +118,19 @@ typedef struct {
 	PHONGO_ZEND_OBJECT_POST
 } php_phongo_readpreference_t;
 
+typedef struct {
+	PHONGO_ZEND_OBJECT_PRE
+	uint8_t*                data;
+	size_t*                 offsets;
+	uint32_t                count;
+	php_phongo_bson_typemap map;
+	HashTable*              key_cache;
+	PHONGO_STRUCT_ZVAL*     cache;
+	uint32_t*               cache_rows;
+	uint32_t                cache_size;
+	PHONGO_ZEND_OBJECT_POST
+} php_phongo_recordset_t;
+
 typedef struct {
 	PHONGO_ZEND_OBJECT_PRE
 	mongoc_client_t* client;
@@ -168,6 +195,13 @@ typedef struct {
 	PHONGO_ZEND_OBJECT_POST
 } php_phongo_dbpointer_t;
 
+typedef struct {
+	PHONGO_ZEND_OBJECT_PRE
+	bson_t*    bson;
+	HashTable* properties;
+	PHONGO_ZEND_OBJECT_POST
+} php_phongo_document_t;
+
 typedef struct {
 	PHONGO_ZEND_OBJECT_PRE
 	bool              initialized;
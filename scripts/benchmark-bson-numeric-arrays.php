@@ -0,0 +1,55 @@
+<?php
+
+/* Measures the per-element cost of decoding and encoding arrays of numbers
+ * with MongoDB\BSON\toPHP() and MongoDB\BSON\fromPHP(). Homogeneous arrays of
+ * int32, int64 and double values take the numeric array fast paths. Each is
+ * compared with the same array followed by a single string, which must go
+ * through the generic element visitors.
+ *
+ * Usage: php scripts/benchmark-bson-numeric-arrays.php [iterations] [elements]
+ */
+
+$iterations = isset($argv[1]) ? (int) $argv[1] : 1000;
+$elements = isset($argv[2]) ? (int) $argv[2] : 10000;
+
+$series = [
+    'int32' => range(0, $elements - 1),
+    'int64' => array_fill(0, $elements, PHP_INT_MAX),
+    'double' => array_map(function($i) { return $i + 0.5; }, range(0, $elements - 1)),
+];
+
+/* PHP integers only exceed the int32 range on 64-bit platforms */
+if (PHP_INT_SIZE === 4) {
+    unset($series['int64']);
+}
+
+function measure(callable $function, $iterations)
+{
+    $start = microtime(true);
+
+    for ($i = 0; $i < $iterations; $i++) {
+        $function();
+    }
+
+    return microtime(true) - $start;
+}
+
+printf("%d iterations of %d elements\n", $iterations, $elements);
+printf("%-8s %-8s %-8s %12s\n", 'type', 'path', 'op', 'ns/element');
+
+foreach ($series as $type => $values) {
+    $mixed = $values;
+    $mixed[] = 'end';
+
+    foreach (['fast' => $values, 'generic' => $mixed] as $path => $array) {
+        $document = ['x' => $array];
+        $bson = MongoDB\BSON\fromPHP($document);
+        $count = count($array) * $iterations;
+
+        $decode = measure(function() use ($bson) { MongoDB\BSON\toPHP($bson); }, $iterations);
+        $encode = measure(function() use ($document) { MongoDB\BSON\fromPHP($document); }, $iterations);
+
+        printf("%-8s %-8s %-8s %12.2f\n", $type, $path, 'decode', $decode * 1e9 / $count);
+        printf("%-8s %-8s %-8s %12.2f\n", $type, $path, 'encode', $encode * 1e9 / $count);
+    }
+}
@@ -0,0 +1,63 @@
+<?php
+
+/* Measures the decoding throughput of MongoDB\BSON\toPHP() for string-heavy
+ * documents, which is dominated by UTF-8 validation of field names and values.
+ * Each document holds the strings of the string and JavaScript code corpora in
+ * tests/bson-corpus, repeated to the requested length.
+ *
+ * Usage: php scripts/benchmark-bson-strings.php [iterations] [string length]
+ */
+
+$iterations = isset($argv[1]) ? (int) $argv[1] : 10000;
+$length = isset($argv[2]) ? (int) $argv[2] : 1024;
+
+$files = array_merge(
+    glob(__DIR__ . '/../tests/bson-corpus/string-valid-*.phpt'),
+    glob(__DIR__ . '/../tests/bson-corpus/code-valid-*.phpt')
+);
+
+$fields = [];
+
+foreach ($files as $file) {
+    if ( ! preg_match("/\\\$canonicalBson = hex2bin\('([0-9A-F]+)'\);/", file_get_contents($file), $matches)) {
+        continue;
+    }
+
+    foreach (MongoDB\BSON\toPHP(hex2bin($matches[1])) as $value) {
+        $string = $value instanceof MongoDB\BSON\Javascript ? $value->getCode() : $value;
+
+        if ( ! is_string($string) || $string === '') {
+            continue;
+        }
+
+        $fields[basename($file, '.phpt')] = substr(str_repeat($string, (int) ceil($length / strlen($string))), 0, $length);
+    }
+}
+
+if (empty($fields)) {
+    printf("No strings found in %s\n", realpath(__DIR__ . '/../tests/bson-corpus'));
+    exit(1);
+}
+
+/* Strings were truncated to the requested length, which may have split a
+ * multi-byte sequence. Such fields are dropped, since they cannot be encoded. */
+foreach ($fields as $name => $string) {
+    try {
+        MongoDB\BSON\fromPHP([$name => $string]);
+    } catch (MongoDB\Driver\Exception\UnexpectedValueException $e) {
+        unset($fields[$name]);
+    }
+}
+
+$bson = MongoDB\BSON\fromPHP($fields);
+
+$start = microtime(true);
+
+for ($i = 0; $i < $iterations; $i++) {
+    MongoDB\BSON\toPHP($bson);
+}
+
+$elapsed = microtime(true) - $start;
+
+printf("%d fields, %d bytes per document\n", count($fields), strlen($bson));
+printf("%d documents in %.3f seconds: %.0f documents/s, %.1f MiB/s\n", $iterations, $elapsed, $iterations / $elapsed, $iterations * strlen($bson) / $elapsed / 1048576);
@@ -0,0 +1,52 @@
+<?php
+
+/* Measures the decoding time of MongoDB\BSON\toPHP() for wide documents and
+ * arrays, which is dominated by growing the hash tables of the decoded values.
+ * Each run decodes a document with the given number of fields, and a document
+ * holding an array with that many elements, as a PHP array and as an object.
+ *
+ * Hash table reallocations cannot be counted from PHP, so the cost of
+ * pre-sizing is shown by comparing the output of builds with and without it.
+ *
+ * Usage: php scripts/benchmark-bson-wide-documents.php [iterations] [fields...]
+ */
+
+$iterations = isset($argv[1]) ? (int) $argv[1] : 10000;
+$widths = count($argv) > 2 ? array_map('intval', array_slice($argv, 2)) : [100, 250, 500, 1000];
+
+function measure(callable $function, $iterations)
+{
+    $start = microtime(true);
+
+    for ($i = 0; $i < $iterations; $i++) {
+        $function();
+    }
+
+    return microtime(true) - $start;
+}
+
+printf("%d iterations\n", $iterations);
+printf("%-8s %-10s %-8s %12s %12s\n", 'fields', 'value', 'root', 'us/document', 'ns/field');
+
+foreach ($widths as $width) {
+    $fields = [];
+
+    for ($i = 0; $i < $width; $i++) {
+        $fields['field' . $i] = 'value' . $i;
+    }
+
+    $values = [
+        'document' => MongoDB\BSON\fromPHP($fields),
+        'array' => MongoDB\BSON\fromPHP(['x' => array_values($fields)]),
+    ];
+
+    foreach ($values as $value => $bson) {
+        foreach (['array', 'object'] as $root) {
+            $typeMap = ['root' => $root, 'document' => $root, 'array' => 'array'];
+
+            $elapsed = measure(function() use ($bson, $typeMap) { MongoDB\BSON\toPHP($bson, $typeMap); }, $iterations);
+
+            printf("%-8d %-10s %-8s %12.2f %12.2f\n", $width, $value, $root, $elapsed * 1e6 / $iterations, $elapsed * 1e9 / ($iterations * $width));
+        }
+    }
+}
@@ -83,6 +83,159 @@ static bool php_phongo_binary_init_from_hash(php_phongo_binary_t* intern, HashTa
 	return false;
 } /* }}} */
 
+/* Returns the number of elements in a vector binary payload, or -1 if the
+ * payload is malformed or uses an unsupported dtype. */
+static int64_t php_phongo_binary_vector_count(const uint8_t* data, size_t data_len) /* {{{ */
+{
+	uint8_t dtype, padding;
+
+	if (data_len < 2) {
+		return -1;
+	}
+
+	dtype   = data[0];
+	padding = data[1];
+
+	switch (dtype) {
+		case PHONGO_BINARY_VECTOR_INT8:
+			return padding == 0 ? (int64_t)(data_len - 2) : -1;
+
+		case PHONGO_BINARY_VECTOR_FLOAT32:
+			return (padding == 0 && (data_len - 2) % 4 == 0) ? (int64_t)((data_len - 2) / 4) : -1;
+
+		case PHONGO_BINARY_VECTOR_PACKED_BIT:
+			if (padding > 7 || (data_len == 2 && padding != 0)) {
+				return -1;
+			}
+
+			return (int64_t)((data_len - 2) * 8 - padding);
+
+		default:
+			return -1;
+	}
+} /* }}} */
+
+static double php_phongo_binary_vector_read_float32(const uint8_t* p) /* {{{ */
+{
+	uint32_t bits;
+	float    value;
+
+	memcpy(&bits, p, sizeof(bits));
+	bits = BSON_UINT32_FROM_LE(bits);
+	memcpy(&value, &bits, sizeof(value));
+
+	return (double) value;
+} /* }}} */
+
+static phongo_long php_phongo_binary_vector_read_long(uint8_t dtype, const uint8_t* payload, size_t i) /* {{{ */
+{
+	if (dtype == PHONGO_BINARY_VECTOR_INT8) {
+		return (int8_t) payload[i];
+	}
+
+	return (payload[i >> 3] >> (7 - (i & 7))) & 1;
+} /* }}} */
+
+/* Decodes the payload of a vector binary into a packed PHP array of floats
+ * (FLOAT32) or integers (INT8 and PACKED_BIT). Returns false without throwing
+ * if the payload is malformed, in which case out is left untouched. */
+bool php_phongo_binary_vector_to_zval(const uint8_t* data, size_t data_len, zval* out TSRMLS_DC) /* {{{ */
+{
+	const uint8_t* payload = data + 2;
+	int64_t        count;
+	int64_t        i;
+	uint8_t        dtype;
+
+	if ((count = php_phongo_binary_vector_count(data, data_len)) < 0) {
+		return false;
+	}
+
+	dtype = data[0];
+
+	array_init_size(out, (uint32_t) count);
+
+#if PHP_VERSION_ID >= 70000
+	zend_hash_real_init(Z_ARRVAL_P(out), 1);
+
+	ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(out))
+	{
+		for (i = 0; i < count; i++) {
+			zval value;
+
+			if (dtype == PHONGO_BINARY_VECTOR_FLOAT32) {
+				ZVAL_DOUBLE(&value, php_phongo_binary_vector_read_float32(payload + i * 4));
+			} else {
+				ZVAL_LONG(&value, php_phongo_binary_vector_read_long(dtype, payload, i));
+			}
+
+			ZEND_HASH_FILL_ADD(&value);
+		}
+	}
+	ZEND_HASH_FILL_END();
+#else
+	for (i = 0; i < count; i++) {
+		if (dtype == PHONGO_BINARY_VECTOR_FLOAT32) {
+			add_next_index_double(out, php_phongo_binary_vector_read_float32(payload + i * 4));
+		} else {
+			add_next_index_long(out, php_phongo_binary_vector_read_long(dtype, payload, i));
+		}
+	}
+#endif
+
+	return true;
+} /* }}} */
+
+/* Writes a PHP value as element i of a vector payload and returns whether it
+ * was successful. An exception will be thrown on error. */
+static bool php_phongo_binary_vector_write_element(uint8_t dtype, uint8_t* payload, uint32_t i, zval* entry TSRMLS_DC) /* {{{ */
+{
+	switch (dtype) {
+		case PHONGO_BINARY_VECTOR_FLOAT32: {
+			uint32_t bits;
+			float    value;
+
+			if (Z_TYPE_P(entry) == IS_DOUBLE) {
+				value = (float) Z_DVAL_P(entry);
+			} else if (Z_TYPE_P(entry) == IS_LONG) {
+				value = (float) Z_LVAL_P(entry);
+			} else {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected vector element %" PRIu32 " to be a number, %s given", i, PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(entry));
+				return false;
+			}
+
+			memcpy(&bits, &value, sizeof(bits));
+			bits = BSON_UINT32_TO_LE(bits);
+			memcpy(payload + i * 4, &bits, sizeof(bits));
+
+			return true;
+		}
+
+		case PHONGO_BINARY_VECTOR_INT8:
+			if (Z_TYPE_P(entry) != IS_LONG || Z_LVAL_P(entry) < INT8_MIN || Z_LVAL_P(entry) > INT8_MAX) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected vector element %" PRIu32 " to be an integer between %d and %d", i, INT8_MIN, INT8_MAX);
+				return false;
+			}
+
+			payload[i] = (uint8_t)(int8_t) Z_LVAL_P(entry);
+
+			return true;
+
+		case PHONGO_BINARY_VECTOR_PACKED_BIT:
+			if (Z_TYPE_P(entry) != IS_LONG || (Z_LVAL_P(entry) != 0 && Z_LVAL_P(entry) != 1)) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected vector element %" PRIu32 " to be 0 or 1", i);
+				return false;
+			}
+
+			if (Z_LVAL_P(entry)) {
+				payload[i >> 3] |= (uint8_t)(0x80 >> (i & 7));
+			}
+
+			return true;
+	}
+
+	return false;
+} /* }}} */
+
 /* {{{ proto void MongoDB\BSON\Binary::__construct(string $data, int $type)
    Construct a new BSON binary type */
 static PHP_METHOD(Binary, __construct)
@@ -170,6 +323,116 @@ static PHP_METHOD(Binary, getType)
 	RETURN_LONG(intern->type);
 } /* }}} */
 
+/* {{{ proto MongoDB\BSON\Binary MongoDB\BSON\Binary::fromVector(array $vector[, int $dtype = MongoDB\BSON\Binary::VECTOR_FLOAT32])
+   Construct a vector binary from an array of numbers */
+static PHP_METHOD(Binary, fromVector)
+{
+	php_phongo_binary_t* intern;
+	zend_error_handling  error_handling;
+	zval*                vector;
+	phongo_long          dtype = PHONGO_BINARY_VECTOR_FLOAT32;
+	HashTable*           ht;
+	uint32_t             count, i = 0;
+	size_t               data_len;
+	uint8_t*             data;
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling TSRMLS_CC);
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a|l", &vector, &dtype) == FAILURE) {
+		zend_restore_error_handling(&error_handling TSRMLS_CC);
+		return;
+	}
+	zend_restore_error_handling(&error_handling TSRMLS_CC);
+
+	ht    = Z_ARRVAL_P(vector);
+	count = zend_hash_num_elements(ht);
+
+	switch (dtype) {
+		case PHONGO_BINARY_VECTOR_INT8:
+			data_len = 2 + (size_t) count;
+			break;
+
+		case PHONGO_BINARY_VECTOR_FLOAT32:
+			data_len = 2 + (size_t) count * 4;
+			break;
+
+		case PHONGO_BINARY_VECTOR_PACKED_BIT:
+			data_len = 2 + ((size_t) count + 7) / 8;
+			break;
+
+		default:
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected dtype to be VECTOR_INT8, VECTOR_FLOAT32, or VECTOR_PACKED_BIT, %" PHONGO_LONG_FORMAT " given", dtype);
+			return;
+	}
+
+	/* Allocate one extra byte so that the data is NUL-terminated like strings
+	 * copied by php_phongo_binary_init() */
+	data    = ecalloc(1, data_len + 1);
+	data[0] = (uint8_t) dtype;
+	data[1] = dtype == PHONGO_BINARY_VECTOR_PACKED_BIT ? (uint8_t)((8 - count % 8) % 8) : 0;
+
+#if PHP_VERSION_ID >= 70000
+	{
+		zval* entry;
+
+		ZEND_HASH_FOREACH_VAL(ht, entry)
+		{
+			ZVAL_DEREF(entry);
+
+			if (!php_phongo_binary_vector_write_element((uint8_t) dtype, data + 2, i++, entry TSRMLS_CC)) {
+				efree(data);
+				return;
+			}
+		}
+		ZEND_HASH_FOREACH_END();
+	}
+#else
+	{
+		HashPosition pos;
+		zval**       entry;
+
+		for (zend_hash_internal_pointer_reset_ex(ht, &pos);
+			 zend_hash_get_current_data_ex(ht, (void**) &entry, &pos) == SUCCESS;
+			 zend_hash_move_forward_ex(ht, &pos)) {
+
+			if (!php_phongo_binary_vector_write_element((uint8_t) dtype, data + 2, i++, *entry TSRMLS_CC)) {
+				efree(data);
+				return;
+			}
+		}
+	}
+#endif
+
+	object_init_ex(return_value, php_phongo_binary_ce);
+
+	intern           = Z_BINARY_OBJ_P(return_value);
+	intern->data     = (char*) data;
+	intern->data_len = data_len;
+	intern->type     = PHONGO_BINARY_SUBTYPE_VECTOR;
+} /* }}} */
+
+/* {{{ proto array MongoDB\BSON\Binary::toArray()
+   Return the elements of a vector binary as an array of numbers */
+static PHP_METHOD(Binary, toArray)
+{
+	php_phongo_binary_t* intern;
+
+	intern = Z_BINARY_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	if (intern->type != PHONGO_BINARY_SUBTYPE_VECTOR) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Expected Binary of type %d (vector), %d given", PHONGO_BINARY_SUBTYPE_VECTOR, intern->type);
+		return;
+	}
+
+	if (!php_phongo_binary_vector_to_zval((const uint8_t*) intern->data, intern->data_len, return_value TSRMLS_CC)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Binary vector data is malformed or uses an unsupported dtype");
+	}
+} /* }}} */
+
 /* {{{ proto array MongoDB\BSON\Binary::jsonSerialize()
 */
 static PHP_METHOD(Binary, jsonSerialize)
@@ -294,6 +557,11 @@ ZEND_BEGIN_ARG_INFO_EX(ai_Binary___construct, 0, 0, 2)
 	ZEND_ARG_INFO(0, type)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_Binary_fromVector, 0, 0, 1)
+	ZEND_ARG_ARRAY_INFO(0, vector, 0)
+	ZEND_ARG_INFO(0, dtype)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_Binary___set_state, 0, 0, 1)
 	ZEND_ARG_ARRAY_INFO(0, properties, 0)
 ZEND_END_ARG_INFO()
@@ -315,6 +583,8 @@ static zend_function_entry php_phongo_binary_me[] = {
 	PHP_ME(Binary, unserialize, ai_Binary_unserialize, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Binary, getData, ai_Binary_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Binary, getType, ai_Binary_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Binary, fromVector, ai_Binary_fromVector, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(Binary, toArray, ai_Binary_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_FE_END
 	/* clang-format on */
 };
@@ -478,6 +748,10 @@ void php_phongo_binary_init_ce(INIT_FUNC_ARGS) /* {{{ */
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_UUID"), BSON_SUBTYPE_UUID TSRMLS_CC);
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_MD5"), BSON_SUBTYPE_MD5 TSRMLS_CC);
 	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_USER_DEFINED"), BSON_SUBTYPE_USER TSRMLS_CC);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("TYPE_VECTOR"), PHONGO_BINARY_SUBTYPE_VECTOR TSRMLS_CC);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_INT8"), PHONGO_BINARY_VECTOR_INT8 TSRMLS_CC);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_FLOAT32"), PHONGO_BINARY_VECTOR_FLOAT32 TSRMLS_CC);
+	zend_declare_class_constant_long(php_phongo_binary_ce, ZEND_STRL("VECTOR_PACKED_BIT"), PHONGO_BINARY_VECTOR_PACKED_BIT TSRMLS_CC);
 } /* }}} */
 
 /*
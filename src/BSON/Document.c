@@ -0,0 +1,634 @@
+/*
+ * Copyright 2018 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <php.h>
+#include <ext/standard/base64.h>
+#include <Zend/zend_interfaces.h>
+#include <ext/standard/php_var.h>
+#if PHP_VERSION_ID >= 70000
+#include <zend_smart_str.h>
+#else
+#include <ext/standard/php_smart_str.h>
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "phongo_compat.h"
+#include "php_phongo.h"
+#include "php_bson.h"
+
+zend_class_entry* php_phongo_document_ce;
+
+/* Initialize the object from a BSON string and return whether it was
+ * successful. The string must contain exactly one valid BSON document. An
+ * exception will be thrown on error. */
+static bool php_phongo_document_init(php_phongo_document_t* intern, const char* data, size_t data_len TSRMLS_DC) /* {{{ */
+{
+	bson_reader_t* reader;
+	const bson_t*  bson;
+	bool           eof = false;
+
+	reader = bson_reader_new_from_data((const uint8_t*) data, data_len);
+
+	if (!(bson = bson_reader_read(reader, NULL))) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Could not read document from BSON reader");
+		bson_reader_destroy(reader);
+		return false;
+	}
+
+	if (!bson_validate(bson, BSON_VALIDATE_NONE, NULL)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected corrupt BSON data");
+		bson_reader_destroy(reader);
+		return false;
+	}
+
+	if (bson_reader_read(reader, &eof) || !eof) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Reading document did not exhaust input buffer");
+		bson_reader_destroy(reader);
+		return false;
+	}
+
+	if (intern->bson) {
+		bson_destroy(intern->bson);
+	}
+
+	intern->bson = bson_copy(bson);
+	bson_reader_destroy(reader);
+
+	return true;
+} /* }}} */
+
+/* Initialize the object from a HashTable and return whether it was successful.
+ * An exception will be thrown on error. */
+static bool php_phongo_document_init_from_hash(php_phongo_document_t* intern, HashTable* props TSRMLS_DC) /* {{{ */
+{
+#if PHP_VERSION_ID >= 70000
+	zval* data;
+
+	if ((data = zend_hash_str_find(props, "data", sizeof("data") - 1)) && Z_TYPE_P(data) == IS_STRING) {
+		zend_string* decoded = php_base64_decode((const unsigned char*) Z_STRVAL_P(data), Z_STRLEN_P(data));
+		bool         retval;
+
+		if (!decoded) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "%s initialization requires valid BSON", ZSTR_VAL(php_phongo_document_ce->name));
+			return false;
+		}
+
+		retval = php_phongo_document_init(intern, ZSTR_VAL(decoded), ZSTR_LEN(decoded) TSRMLS_CC);
+		zend_string_free(decoded);
+
+		return retval;
+	}
+#else
+	zval** data;
+
+	if (zend_hash_find(props, "data", sizeof("data"), (void**) &data) == SUCCESS && Z_TYPE_PP(data) == IS_STRING) {
+		int            decoded_len = 0;
+		unsigned char* decoded     = php_base64_decode((const unsigned char*) Z_STRVAL_PP(data), Z_STRLEN_PP(data), &decoded_len);
+		bool           retval;
+
+		if (!decoded) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "%s initialization requires valid BSON", ZSTR_VAL(php_phongo_document_ce->name));
+			return false;
+		}
+
+		retval = php_phongo_document_init(intern, (const char*) decoded, decoded_len TSRMLS_CC);
+		efree(decoded);
+
+		return retval;
+	}
+#endif
+
+	phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "%s initialization requires \"data\" string field", ZSTR_VAL(php_phongo_document_ce->name));
+	return false;
+} /* }}} */
+
+/* Converts the BSON value at the iterator's position to a PHP value. Embedded
+ * documents are returned as Document instances without being visited. Other
+ * values are appended to a single-element wrapper document, which is decoded
+ * with the regular visitors; documents nested within arrays are also returned
+ * as Document instances. */
+static void php_phongo_document_iter_to_zval(const bson_iter_t* iter, zval* return_value TSRMLS_DC) /* {{{ */
+{
+	bson_t                wrapper = BSON_INITIALIZER;
+	php_phongo_bson_state state   = PHONGO_BSON_STATE_INITIALIZER;
+
+	if (BSON_ITER_HOLDS_DOCUMENT(iter)) {
+		uint32_t       len;
+		const uint8_t* data;
+
+		bson_iter_document(iter, &len, &data);
+		php_phongo_new_document_from_bson(return_value, data, len TSRMLS_CC);
+		return;
+	}
+
+	if (!bson_append_iter(&wrapper, "v", 1, iter)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Could not copy BSON value");
+		bson_destroy(&wrapper);
+		return;
+	}
+
+	state.map.root_type     = PHONGO_TYPEMAP_NATIVE_ARRAY;
+	state.map.document_type = PHONGO_TYPEMAP_BSON;
+
+	if (!php_phongo_bson_to_zval_ex(bson_get_data(&wrapper), wrapper.len, &state)) {
+		zval_ptr_dtor(&state.zchild);
+		bson_destroy(&wrapper);
+		return;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	{
+		zval* value = zend_hash_str_find(Z_ARRVAL(state.zchild), "v", sizeof("v") - 1);
+
+		if (value) {
+			RETVAL_ZVAL(value, 1, 0);
+		}
+	}
+#else
+	{
+		zval** value;
+
+		if (zend_hash_find(Z_ARRVAL_P(state.zchild), "v", sizeof("v"), (void**) &value) == SUCCESS) {
+			RETVAL_ZVAL(*value, 1, 0);
+		}
+	}
+#endif
+
+	zval_ptr_dtor(&state.zchild);
+	bson_destroy(&wrapper);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Document MongoDB\BSON\Document::fromBSON(string $bson)
+   Construct a Document from a BSON string */
+static PHP_METHOD(Document, fromBSON)
+{
+	php_phongo_document_t* intern;
+	char*                  data;
+	phongo_zpp_char_len    data_len;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &data, &data_len) == FAILURE) {
+		return;
+	}
+
+	object_init_ex(return_value, php_phongo_document_ce);
+
+	intern = Z_DOCUMENT_OBJ_P(return_value);
+
+	php_phongo_document_init(intern, data, data_len TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto MongoDB\BSON\Document MongoDB\BSON\Document::fromPHP(array|object $value)
+   Construct a Document from a PHP value */
+static PHP_METHOD(Document, fromPHP)
+{
+	php_phongo_document_t* intern;
+	zval*                  data;
+	bson_t*                bson;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "A", &data) == FAILURE) {
+		return;
+	}
+
+	bson = bson_new();
+	php_phongo_zval_to_bson(data, PHONGO_BSON_NONE, bson, NULL TSRMLS_CC);
+
+	if (EG(exception)) {
+		bson_destroy(bson);
+		return;
+	}
+
+	object_init_ex(return_value, php_phongo_document_ce);
+
+	intern       = Z_DOCUMENT_OBJ_P(return_value);
+	intern->bson = bson;
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\BSON\Document::get(string $key)
+   Returns the value of a top-level field, decoding only that field */
+static PHP_METHOD(Document, get)
+{
+	php_phongo_document_t* intern;
+	char*                  key;
+	phongo_zpp_char_len    key_len;
+	bson_iter_t            iter;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &key, &key_len) == FAILURE) {
+		return;
+	}
+
+	if (!bson_iter_init(&iter, php_phongo_document_get_bson(intern)) || !bson_iter_find(&iter, key)) {
+		phongo_throw_exception(PHONGO_ERROR_RUNTIME TSRMLS_CC, "Could not find key \"%s\" in BSON document", key);
+		return;
+	}
+
+	php_phongo_document_iter_to_zval(&iter, return_value TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\Document::has(string $key)
+   Returns whether a top-level field exists */
+static PHP_METHOD(Document, has)
+{
+	php_phongo_document_t* intern;
+	char*                  key;
+	phongo_zpp_char_len    key_len;
+	bson_iter_t            iter;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &key, &key_len) == FAILURE) {
+		return;
+	}
+
+	RETURN_BOOL(bson_iter_init(&iter, php_phongo_document_get_bson(intern)) && bson_iter_find(&iter, key));
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\BSON\Document::getPath(string $path)
+   Returns the value of a field identified by a dotted path (e.g. "a.b.c") */
+static PHP_METHOD(Document, getPath)
+{
+	php_phongo_document_t* intern;
+	char*                  path;
+	phongo_zpp_char_len    path_len;
+	bson_iter_t            iter;
+	bson_iter_t            target;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &path, &path_len) == FAILURE) {
+		return;
+	}
+
+	if (!bson_iter_init(&iter, php_phongo_document_get_bson(intern)) || !bson_iter_find_descendant(&iter, path, &target)) {
+		phongo_throw_exception(PHONGO_ERROR_RUNTIME TSRMLS_CC, "Could not find path \"%s\" in BSON document", path);
+		return;
+	}
+
+	php_phongo_document_iter_to_zval(&target, return_value TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\BSON\Document::hasPath(string $path)
+   Returns whether a field identified by a dotted path exists */
+static PHP_METHOD(Document, hasPath)
+{
+	php_phongo_document_t* intern;
+	char*                  path;
+	phongo_zpp_char_len    path_len;
+	bson_iter_t            iter;
+	bson_iter_t            target;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &path, &path_len) == FAILURE) {
+		return;
+	}
+
+	RETURN_BOOL(bson_iter_init(&iter, php_phongo_document_get_bson(intern)) && bson_iter_find_descendant(&iter, path, &target));
+} /* }}} */
+
+/* {{{ proto array|object MongoDB\BSON\Document::toPHP([array $typemap = array()])
+   Returns the PHP representation of the document */
+static PHP_METHOD(Document, toPHP)
+{
+	php_phongo_document_t* intern;
+	const bson_t*          bson;
+	zval*                  typemap = NULL;
+	php_phongo_bson_state  state   = PHONGO_BSON_STATE_INITIALIZER;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|a!", &typemap) == FAILURE) {
+		return;
+	}
+
+	if (!php_phongo_bson_typemap_to_state(typemap, &state.map TSRMLS_CC)) {
+		return;
+	}
+
+	bson = php_phongo_document_get_bson(intern);
+
+	if (!php_phongo_bson_to_zval_ex(bson_get_data(bson), bson->len, &state)) {
+		zval_ptr_dtor(&state.zchild);
+		php_phongo_bson_typemap_dtor(&state.map);
+		RETURN_NULL();
+	}
+
+	php_phongo_bson_typemap_dtor(&state.map);
+
+#if PHP_VERSION_ID >= 70000
+	RETURN_ZVAL(&state.zchild, 0, 1);
+#else
+	RETURN_ZVAL(state.zchild, 0, 1);
+#endif
+} /* }}} */
+
+/* {{{ proto string MongoDB\BSON\Document::__toString()
+   Return the BSON string of the document */
+static PHP_METHOD(Document, __toString)
+{
+	php_phongo_document_t* intern;
+	const bson_t*          bson;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+	bson   = php_phongo_document_get_bson(intern);
+
+	PHONGO_RETURN_STRINGL((const char*) bson_get_data(bson), bson->len);
+} /* }}} */
+
+/* {{{ proto string MongoDB\BSON\Document::serialize()
+*/
+static PHP_METHOD(Document, serialize)
+{
+	php_phongo_document_t* intern;
+	const bson_t*          bson;
+	ZVAL_RETVAL_TYPE       retval;
+	php_serialize_data_t   var_hash;
+	smart_str              buf = { 0 };
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+	bson   = php_phongo_document_get_bson(intern);
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	array_init_size(&retval, 1);
+	{
+		zend_string* data = php_base64_encode(bson_get_data(bson), bson->len);
+		ADD_ASSOC_STRINGL(&retval, "data", ZSTR_VAL(data), ZSTR_LEN(data));
+		zend_string_free(data);
+	}
+#else
+	ALLOC_INIT_ZVAL(retval);
+	array_init_size(retval, 1);
+	{
+		int            data_len = 0;
+		unsigned char* data     = php_base64_encode(bson_get_data(bson), bson->len, &data_len);
+		ADD_ASSOC_STRINGL(retval, "data", (char*) data, data_len);
+		efree(data);
+	}
+#endif
+
+	PHP_VAR_SERIALIZE_INIT(var_hash);
+	php_var_serialize(&buf, &retval, &var_hash TSRMLS_CC);
+	smart_str_0(&buf);
+	PHP_VAR_SERIALIZE_DESTROY(var_hash);
+
+	PHONGO_RETVAL_SMART_STR(buf);
+
+	smart_str_free(&buf);
+	zval_ptr_dtor(&retval);
+} /* }}} */
+
+/* {{{ proto void MongoDB\BSON\Document::unserialize(string $serialized)
+*/
+static PHP_METHOD(Document, unserialize)
+{
+	php_phongo_document_t* intern;
+	zend_error_handling    error_handling;
+	char*                  serialized;
+	phongo_zpp_char_len    serialized_len;
+#if PHP_VERSION_ID >= 70000
+	zval props;
+#else
+	zval* props;
+#endif
+	php_unserialize_data_t var_hash;
+
+	intern = Z_DOCUMENT_OBJ_P(getThis());
+
+	zend_replace_error_handling(EH_THROW, phongo_exception_from_phongo_domain(PHONGO_ERROR_INVALID_ARGUMENT), &error_handling TSRMLS_CC);
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &serialized, &serialized_len) == FAILURE) {
+		zend_restore_error_handling(&error_handling TSRMLS_CC);
+		return;
+	}
+	zend_restore_error_handling(&error_handling TSRMLS_CC);
+
+#if PHP_VERSION_ID < 70000
+	ALLOC_INIT_ZVAL(props);
+#endif
+	PHP_VAR_UNSERIALIZE_INIT(var_hash);
+	if (!php_var_unserialize(&props, (const unsigned char**) &serialized, (unsigned char*) serialized + serialized_len, &var_hash TSRMLS_CC)) {
+		zval_ptr_dtor(&props);
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "%s unserialization failed", ZSTR_VAL(php_phongo_document_ce->name));
+
+		PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+		return;
+	}
+	PHP_VAR_UNSERIALIZE_DESTROY(var_hash);
+
+#if PHP_VERSION_ID >= 70000
+	php_phongo_document_init_from_hash(intern, HASH_OF(&props) TSRMLS_CC);
+#else
+	php_phongo_document_init_from_hash(intern, HASH_OF(props) TSRMLS_CC);
+#endif
+	zval_ptr_dtor(&props);
+} /* }}} */
+
+/* {{{ MongoDB\BSON\Document function entries */
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_fromBSON, 0, 0, 1)
+	ZEND_ARG_INFO(0, bson)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_fromPHP, 0, 0, 1)
+	ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_key, 0, 0, 1)
+	ZEND_ARG_INFO(0, key)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_path, 0, 0, 1)
+	ZEND_ARG_INFO(0, path)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_toPHP, 0, 0, 0)
+	ZEND_ARG_ARRAY_INFO(0, typemap, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_unserialize, 0, 0, 1)
+	ZEND_ARG_INFO(0, serialized)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Document_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_document_me[] = {
+	/* clang-format off */
+	PHP_ME(Document, fromBSON, ai_Document_fromBSON, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(Document, fromPHP, ai_Document_fromPHP, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(Document, get, ai_Document_key, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, has, ai_Document_key, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, getPath, ai_Document_path, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, hasPath, ai_Document_path, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, toPHP, ai_Document_toPHP, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, __toString, ai_Document_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, serialize, ai_Document_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Document, unserialize, ai_Document_unserialize, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_Document_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	PHP_FE_END
+	/* clang-format on */
+};
+/* }}} */
+
+/* {{{ MongoDB\BSON\Document object handlers */
+static zend_object_handlers php_phongo_handler_document;
+
+static void php_phongo_document_free_object(phongo_free_object_arg* object TSRMLS_DC) /* {{{ */
+{
+	php_phongo_document_t* intern = Z_OBJ_DOCUMENT(object);
+
+	zend_object_std_dtor(&intern->std TSRMLS_CC);
+
+	if (intern->bson) {
+		bson_destroy(intern->bson);
+	}
+
+	if (intern->properties) {
+		zend_hash_destroy(intern->properties);
+		FREE_HASHTABLE(intern->properties);
+	}
+
+#if PHP_VERSION_ID < 70000
+	efree(intern);
+#endif
+} /* }}} */
+
+static phongo_create_object_retval php_phongo_document_create_object(zend_class_entry* class_type TSRMLS_DC) /* {{{ */
+{
+	php_phongo_document_t* intern = NULL;
+
+	intern = PHONGO_ALLOC_OBJECT_T(php_phongo_document_t, class_type);
+
+	zend_object_std_init(&intern->std, class_type TSRMLS_CC);
+	object_properties_init(&intern->std, class_type);
+
+#if PHP_VERSION_ID >= 70000
+	intern->std.handlers = &php_phongo_handler_document;
+
+	return &intern->std;
+#else
+	{
+		zend_object_value retval;
+		retval.handle   = zend_objects_store_put(intern, (zend_objects_store_dtor_t) zend_objects_destroy_object, php_phongo_document_free_object, NULL TSRMLS_CC);
+		retval.handlers = &php_phongo_handler_document;
+
+		return retval;
+	}
+#endif
+} /* }}} */
+
+static HashTable* php_phongo_document_get_gc(zval* object, phongo_get_gc_table table, int* n TSRMLS_DC) /* {{{ */
+{
+	*table = NULL;
+	*n     = 0;
+
+	return Z_DOCUMENT_OBJ_P(object)->properties;
+} /* }}} */
+
+static HashTable* php_phongo_document_get_properties_hash(zval* object, bool is_debug TSRMLS_DC) /* {{{ */
+{
+	php_phongo_document_t* intern;
+	const bson_t*          bson;
+	HashTable*             props;
+
+	intern = Z_DOCUMENT_OBJ_P(object);
+	bson   = php_phongo_document_get_bson(intern);
+
+	PHONGO_GET_PROPERTY_HASH_INIT_PROPS(is_debug, intern, props, 2);
+
+#if PHP_VERSION_ID >= 70000
+	{
+		zval         data, length;
+		zend_string* encoded = php_base64_encode(bson_get_data(bson), bson->len);
+
+		ZVAL_STR(&data, encoded);
+		zend_hash_str_update(props, "data", sizeof("data") - 1, &data);
+
+		ZVAL_LONG(&length, bson->len);
+		zend_hash_str_update(props, "length", sizeof("length") - 1, &length);
+	}
+#else
+	{
+		zval *         data, *length;
+		int            encoded_len = 0;
+		unsigned char* encoded     = php_base64_encode(bson_get_data(bson), bson->len, &encoded_len);
+
+		MAKE_STD_ZVAL(data);
+		ZVAL_STRINGL(data, (char*) encoded, encoded_len, 0);
+		zend_hash_update(props, "data", sizeof("data"), &data, sizeof(data), NULL);
+
+		MAKE_STD_ZVAL(length);
+		ZVAL_LONG(length, bson->len);
+		zend_hash_update(props, "length", sizeof("length"), &length, sizeof(length), NULL);
+	}
+#endif
+
+	return props;
+} /* }}} */
+
+static HashTable* php_phongo_document_get_debug_info(zval* object, int* is_temp TSRMLS_DC) /* {{{ */
+{
+	*is_temp = 1;
+	return php_phongo_document_get_properties_hash(object, true TSRMLS_CC);
+} /* }}} */
+
+static HashTable* php_phongo_document_get_properties(zval* object TSRMLS_DC) /* {{{ */
+{
+	return php_phongo_document_get_properties_hash(object, false TSRMLS_CC);
+} /* }}} */
+/* }}} */
+
+void php_phongo_document_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\BSON", "Document", php_phongo_document_me);
+	php_phongo_document_ce                = zend_register_internal_class(&ce TSRMLS_CC);
+	php_phongo_document_ce->create_object = php_phongo_document_create_object;
+	PHONGO_CE_FINAL(php_phongo_document_ce);
+
+	zend_class_implements(php_phongo_document_ce TSRMLS_CC, 1, php_phongo_type_ce);
+	zend_class_implements(php_phongo_document_ce TSRMLS_CC, 1, zend_ce_serializable);
+
+	memcpy(&php_phongo_handler_document, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_document.get_debug_info = php_phongo_document_get_debug_info;
+	php_phongo_handler_document.get_gc         = php_phongo_document_get_gc;
+	php_phongo_handler_document.get_properties = php_phongo_document_get_properties;
+#if PHP_VERSION_ID >= 70000
+	php_phongo_handler_document.free_obj = php_phongo_document_free_object;
+	php_phongo_handler_document.offset   = XtOffsetOf(php_phongo_document_t, std);
+#endif
+} /* }}} */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4
+ */
@@ -231,14 +231,33 @@ static PHP_METHOD(UTCDateTime, __toString)
 	PHONGO_RETVAL_STRINGL(s_milliseconds, s_milliseconds_len);
 } /* }}} */
 
+/* Initializes a DateTime or DateTimeImmutable object (depending on ce) from a
+ * number of milliseconds since the epoch. */
+void php_phongo_new_datetime_from_epoch(zval* object, int64_t msec_since_epoch, zend_class_entry* ce TSRMLS_DC) /* {{{ */
+{
+	php_date_obj* datetime_obj;
+	char*         sec;
+	size_t        sec_len;
+
+	object_init_ex(object, ce);
+	datetime_obj = Z_PHPDATE_P(object);
+
+	sec_len = spprintf(&sec, 0, "@%" PRId64, msec_since_epoch / 1000);
+	php_date_initialize(datetime_obj, sec, sec_len, NULL, NULL, 0 TSRMLS_CC);
+	efree(sec);
+
+#if PHP_VERSION_ID >= 70200
+	datetime_obj->time->us = (msec_since_epoch % 1000) * 1000;
+#else
+	datetime_obj->time->f = (double) (msec_since_epoch % 1000) / 1000;
+#endif
+} /* }}} */
+
 /* {{{ proto DateTime MongoDB\BSON\UTCDateTime::toDateTime()
    Returns a DateTime object representing this UTCDateTime */
 static PHP_METHOD(UTCDateTime, toDateTime)
 {
 	php_phongo_utcdatetime_t* intern;
-	php_date_obj*             datetime_obj;
-	char*                     sec;
-	size_t                    sec_len;
 
 	intern = Z_UTCDATETIME_OBJ_P(getThis());
 
@@ -246,18 +265,7 @@ static PHP_METHOD(UTCDateTime, toDateTime)
 		return;
 	}
 
-	object_init_ex(return_value, php_date_get_date_ce());
-	datetime_obj = Z_PHPDATE_P(return_value);
-
-	sec_len = spprintf(&sec, 0, "@%" PRId64, intern->milliseconds / 1000);
-	php_date_initialize(datetime_obj, sec, sec_len, NULL, NULL, 0 TSRMLS_CC);
-	efree(sec);
-
-#if PHP_VERSION_ID >= 70200
-	datetime_obj->time->us = (intern->milliseconds % 1000) * 1000;
-#else
-	datetime_obj->time->f = (double) (intern->milliseconds % 1000) / 1000;
-#endif
+	php_phongo_new_datetime_from_epoch(return_value, intern->milliseconds, php_date_get_date_ce() TSRMLS_CC);
 }
 /* }}} */
 
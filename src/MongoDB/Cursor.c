@@ -25,9 +25,14 @@
 #include "phongo_compat.h"
 #include "php_phongo.h"
 #include "php_bson.h"
+#include "php_array_api.h"
 
 zend_class_entry* php_phongo_cursor_ce;
 
+/* JSON written by exportJSON() is buffered and written to the stream in chunks
+ * of at least this size */
+#define PHONGO_EXPORT_JSON_CHUNK_SIZE 65536
+
 /* Check if the cursor is exhausted (i.e. ID is zero) and free any reference to
  * the session. Calling this function during iteration will allow an implicit
  * session to return to the pool immediately after a getMore indicates that the
@@ -52,6 +57,122 @@ static void php_phongo_cursor_free_current(php_phongo_cursor_t* cursor) /* {{{ *
 	}
 } /* }}} */
 
+/* Decodes a document as the cursor's current element. If document recycling
+ * is enabled, the previous element's array or object is overwritten in place
+ * when possible; otherwise, it is freed and a new one is created. */
+static void php_phongo_cursor_decode_current(php_phongo_cursor_t* cursor, const bson_t* doc) /* {{{ */
+{
+	if (cursor->recycle_documents && !Z_ISUNDEF(cursor->visitor_data.zchild) &&
+		php_phongo_bson_to_zval_recycle(bson_get_data(doc), doc->len, &cursor->visitor_data)) {
+		return;
+	}
+
+	php_phongo_cursor_free_current(cursor);
+	php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &cursor->visitor_data);
+} /* }}} */
+
+/* Appends a document consumed from the libmongoc cursor to the replay buffer.
+ * Documents are stored back to back as raw BSON, which is far more compact
+ * than decoded PHP values and can be read without any per-document
+ * bookkeeping. */
+static void php_phongo_cursor_replay_append(php_phongo_cursor_t* cursor, const bson_t* doc) /* {{{ */
+{
+	if (cursor->replay_len + doc->len > cursor->replay_alloc) {
+		size_t alloc = cursor->replay_alloc ? cursor->replay_alloc : 4096;
+
+		while (alloc < cursor->replay_len + doc->len) {
+			alloc *= 2;
+		}
+
+		cursor->replay_buffer = erealloc(cursor->replay_buffer, alloc);
+		cursor->replay_alloc  = alloc;
+	}
+
+	memcpy(cursor->replay_buffer + cursor->replay_len, bson_get_data(doc), doc->len);
+	cursor->replay_len += doc->len;
+} /* }}} */
+
+/* Initializes a static bson_t for the document at the given offset within the
+ * replay buffer */
+static void php_phongo_cursor_replay_document(php_phongo_cursor_t* cursor, size_t pos, bson_t* doc) /* {{{ */
+{
+	uint32_t len;
+
+	memcpy(&len, cursor->replay_buffer + pos, sizeof(len));
+	bson_init_static(doc, cursor->replay_buffer + pos, BSON_UINT32_FROM_LE(len));
+} /* }}} */
+
+/* Returns the BSON document for the cursor's current element, which is read
+ * from the replay buffer while replaying. The static bson_t is used as storage
+ * for documents read from the replay buffer. */
+static const bson_t* php_phongo_cursor_current_document(php_phongo_cursor_t* cursor, bson_t* replayed) /* {{{ */
+{
+	if (cursor->replaying) {
+		php_phongo_cursor_replay_document(cursor, cursor->replay_pos, replayed);
+		return replayed;
+	}
+
+	return mongoc_cursor_current(cursor->cursor);
+} /* }}} */
+
+/* Records the size of a document consumed from the cursor, which is used to
+ * derive the batch size for subsequent getMore commands */
+static inline void php_phongo_cursor_observe_document(php_phongo_cursor_t* cursor, const bson_t* doc) /* {{{ */
+{
+	cursor->observed_bytes += doc->len;
+	cursor->observed_count++;
+} /* }}} */
+
+/* Sets the batch size for the next getMore so that a batch of documents of the
+ * average size observed so far fits within the cursor's byte budget. The batch
+ * size is only changed on the libmongoc cursor if it differs from the last one
+ * applied. */
+static void php_phongo_cursor_tune_batch_size(php_phongo_cursor_t* cursor) /* {{{ */
+{
+	uint64_t average;
+	uint64_t batch_size;
+
+	if (!cursor->observed_count) {
+		return;
+	}
+
+	average    = cursor->observed_bytes / cursor->observed_count;
+	batch_size = average ? cursor->adaptive_batch_bytes / average : cursor->adaptive_batch_bytes;
+
+	if (batch_size < 1) {
+		batch_size = 1;
+	}
+
+	if (batch_size > INT32_MAX) {
+		batch_size = INT32_MAX;
+	}
+
+	if (batch_size != cursor->adaptive_batch_size) {
+		cursor->adaptive_batch_size = (uint32_t) batch_size;
+		mongoc_cursor_set_batch_size(cursor->cursor, cursor->adaptive_batch_size);
+	}
+} /* }}} */
+
+/* Advances the libmongoc cursor. If adaptive batch sizing is enabled, any
+ * getMore issued to obtain the next document will request a batch size derived
+ * from the documents consumed so far. */
+static bool php_phongo_cursor_next(php_phongo_cursor_t* cursor, const bson_t** doc) /* {{{ */
+{
+	if (cursor->adaptive_batch_bytes) {
+		php_phongo_cursor_tune_batch_size(cursor);
+	}
+
+	if (!mongoc_cursor_next(cursor->cursor, doc)) {
+		return false;
+	}
+
+	if (cursor->adaptive_batch_bytes) {
+		php_phongo_cursor_observe_document(cursor, *doc);
+	}
+
+	return true;
+} /* }}} */
+
 /* {{{ MongoDB\Driver\Cursor iterator handlers */
 static void php_phongo_cursor_iterator_dtor(zend_object_iterator* iter TSRMLS_DC) /* {{{ */
 {
@@ -111,7 +232,11 @@ static void php_phongo_cursor_iterator_move_forward(zend_object_iterator* iter T
 	php_phongo_cursor_t*        cursor    = cursor_it->cursor;
 	const bson_t*               doc;
 
-	php_phongo_cursor_free_current(cursor);
+	/* A recycled element is only freed if there is no next document to
+	 * overwrite it with */
+	if (!cursor->recycle_documents) {
+		php_phongo_cursor_free_current(cursor);
+	}
 
 	/* If the cursor has already advanced, increment its position. Otherwise,
 	 * the first call to mongoc_cursor_next() will be made below and we should
@@ -122,11 +247,35 @@ static void php_phongo_cursor_iterator_move_forward(zend_object_iterator* iter T
 		cursor->advanced = true;
 	}
 
-	if (mongoc_cursor_next(cursor->cursor, &doc)) {
-		php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &cursor->visitor_data);
+	/* While replaying, documents are read from the replay buffer until its last
+	 * document, which is the libmongoc cursor's current document, has been
+	 * yielded. Iteration then continues with the libmongoc cursor. */
+	if (cursor->replaying) {
+		bson_t replayed;
+
+		php_phongo_cursor_replay_document(cursor, cursor->replay_pos, &replayed);
+
+		if (cursor->replay_pos + replayed.len < cursor->replay_len) {
+			cursor->replay_pos += replayed.len;
+			php_phongo_cursor_replay_document(cursor, cursor->replay_pos, &replayed);
+			php_phongo_cursor_decode_current(cursor, &replayed);
+			return;
+		}
+
+		cursor->replaying = false;
+	}
+
+	if (php_phongo_cursor_next(cursor, &doc)) {
+		if (cursor->replayable) {
+			php_phongo_cursor_replay_append(cursor, doc);
+		}
+
+		php_phongo_cursor_decode_current(cursor, doc);
 	} else {
 		bson_error_t error = { 0 };
 
+		php_phongo_cursor_free_current(cursor);
+
 		if (mongoc_cursor_error(cursor->cursor, &error)) {
 			/* Intentionally not destroying the cursor as it will happen
 			 * naturally now that there are no more results */
@@ -153,6 +302,23 @@ static void php_phongo_cursor_iterator_rewind(zend_object_iterator* iter TSRMLS_
 		}
 	}
 
+	/* A replayable cursor rewinds to the first document in its replay buffer,
+	 * which contains every document consumed so far */
+	if (cursor->replayable && cursor->replay_len > 0) {
+		bson_t replayed;
+
+		php_phongo_cursor_free_current(cursor);
+
+		cursor->current    = 0;
+		cursor->replaying  = true;
+		cursor->replay_pos = 0;
+
+		php_phongo_cursor_replay_document(cursor, 0, &replayed);
+		php_phongo_bson_to_zval_ex(bson_get_data(&replayed), replayed.len, &cursor->visitor_data);
+
+		return;
+	}
+
 	if (cursor->current > 0) {
 		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot rewind after starting iteration");
 		return;
@@ -163,6 +329,10 @@ static void php_phongo_cursor_iterator_rewind(zend_object_iterator* iter TSRMLS_
 	doc = mongoc_cursor_current(cursor->cursor);
 
 	if (doc) {
+		if (cursor->replayable) {
+			php_phongo_cursor_replay_append(cursor, doc);
+		}
+
 		php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &cursor->visitor_data);
 	}
 
@@ -188,11 +358,18 @@ static zend_object_iterator* php_phongo_cursor_get_iterator(zend_class_entry* ce
 		zend_error(E_ERROR, "An iterator cannot be used with foreach by reference");
 	}
 
-	if (cursor->got_iterator) {
+	/* Replayable cursors may be iterated again, since rewinding replays the
+	 * documents consumed so far */
+	if (cursor->got_iterator && !cursor->replayable) {
 		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot yield multiple iterators");
 		return NULL;
 	}
 
+	if (cursor->got_batch) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot yield an iterator after fetching batches");
+		return NULL;
+	}
+
 	cursor->got_iterator = true;
 
 	cursor_it = ecalloc(1, sizeof(php_phongo_cursor_iterator));
@@ -244,14 +421,19 @@ static PHP_METHOD(Cursor, setTypeMap)
 
 	php_phongo_bson_typemap_dtor(&intern->visitor_data.map);
 
+	/* Retain the key cache, which does not depend on the type map */
+	state.key_cache      = intern->visitor_data.key_cache;
 	intern->visitor_data = state;
 
 	/* If the cursor has a current element, we just freed it and should restore
 	 * it with a new type map applied. */
-	if (restore_current_element && mongoc_cursor_current(intern->cursor)) {
-		const bson_t* doc = mongoc_cursor_current(intern->cursor);
+	if (restore_current_element) {
+		bson_t        replayed;
+		const bson_t* doc = php_phongo_cursor_current_document(intern, &replayed);
 
-		php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &intern->visitor_data);
+		if (doc) {
+			php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &intern->visitor_data);
+		}
 	}
 } /* }}} */
 
@@ -294,125 +476,1195 @@ static int php_phongo_cursor_to_array_apply(zend_object_iterator* iter, void* pu
    Returns an array of all result documents for this cursor */
 static PHP_METHOD(Cursor, toArray)
 {
+	php_phongo_cursor_t* intern;
+	bool                 recycle_documents;
+
 	if (zend_parse_parameters_none() == FAILURE) {
 		return;
 	}
 
+	intern = Z_CURSOR_OBJ_P(getThis());
+
 	array_init(return_value);
 
+	/* Each document is retained in the returned array, so none of them may be
+	 * recycled */
+	recycle_documents         = intern->recycle_documents;
+	intern->recycle_documents = false;
+
 	if (spl_iterator_apply(getThis(), php_phongo_cursor_to_array_apply, (void*) return_value TSRMLS_CC) != SUCCESS) {
 		zval_dtor(return_value);
-		RETURN_NULL();
+		RETVAL_NULL();
 	}
+
+	intern->recycle_documents = recycle_documents;
 } /* }}} */
 
-/* {{{ proto MongoDB\Driver\CursorId MongoDB\Driver\Cursor::getId()
-   Returns the CursorId for this cursor */
-static PHP_METHOD(Cursor, getId)
+/* Appends a document to the batch returned by nextBatch(), either as a raw
+ * BSON string or decoded with the cursor's type map. Returns false if decoding
+ * failed, in which case an exception will have been thrown. */
+static bool php_phongo_cursor_add_to_batch(php_phongo_cursor_t* cursor, zval* batch, const bson_t* doc, bool raw TSRMLS_DC) /* {{{ */
+{
+	if (raw) {
+		ADD_NEXT_INDEX_STRINGL(batch, (const char*) bson_get_data(doc), doc->len);
+		return true;
+	}
+
+	if (!php_phongo_bson_to_zval_ex(bson_get_data(doc), doc->len, &cursor->visitor_data)) {
+		php_phongo_cursor_free_current(cursor);
+		return false;
+	}
+
+	/* Ownership of the decoded document moves to the batch */
+#if PHP_VERSION_ID >= 70000
+	add_next_index_zval(batch, &cursor->visitor_data.zchild);
+#else
+	add_next_index_zval(batch, cursor->visitor_data.zchild);
+#endif
+	ZVAL_UNDEF(&cursor->visitor_data.zchild);
+
+	return true;
+} /* }}} */
+
+/* {{{ proto array MongoDB\Driver\Cursor::nextBatch([boolean $raw = false])
+   Returns the documents buffered from the last server reply, issuing at most
+   one getMore if no documents are buffered */
+static PHP_METHOD(Cursor, nextBatch)
 {
 	php_phongo_cursor_t* intern;
+	zend_bool            raw = 0;
+	const bson_t*        doc;
+	uint32_t             getmore_count;
 
 	intern = Z_CURSOR_OBJ_P(getThis());
 
-	if (zend_parse_parameters_none() == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|b", &raw) == FAILURE) {
 		return;
 	}
 
-	php_phongo_cursor_id_new_from_id(return_value, mongoc_cursor_get_id(intern->cursor) TSRMLS_CC);
+	if (intern->got_iterator) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot fetch batches after starting iteration");
+		return;
+	}
+
+	if (intern->replayable) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Replayable cursors cannot fetch batches");
+		return;
+	}
+
+	intern->got_batch = true;
+
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!intern->advanced) {
+		intern->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(intern->cursor TSRMLS_CC)) {
+			/* Exception should already have been thrown */
+			return;
+		}
+	}
+
+	array_init(return_value);
+
+	/* The cursor's current document belongs to this batch unless a previous
+	 * call already returned it */
+	if (!intern->consumed_current && (doc = mongoc_cursor_current(intern->cursor))) {
+		if (!php_phongo_cursor_add_to_batch(intern, return_value, doc, raw TSRMLS_CC)) {
+			goto failure;
+		}
+	}
+
+	intern->consumed_current = true;
+
+	for (;;) {
+		getmore_count = MONGODB_G(getmore_count);
+
+		if (!php_phongo_cursor_next(intern, &doc)) {
+			bson_error_t error = { 0 };
+
+			if (EG(exception)) {
+				goto failure;
+			}
+
+			if (mongoc_cursor_error(intern->cursor, &error)) {
+				phongo_throw_exception_from_bson_error_t(&error TSRMLS_CC);
+				goto failure;
+			}
+
+			break;
+		}
+
+		/* A getMore was issued to obtain this document, so it begins the next
+		 * batch. It is left as the cursor's current document unless this batch
+		 * was empty, in which case the new batch is returned instead. */
+		if (getmore_count != MONGODB_G(getmore_count) && zend_hash_num_elements(Z_ARRVAL_P(return_value)) > 0) {
+			intern->consumed_current = false;
+			break;
+		}
+
+		if (!php_phongo_cursor_add_to_batch(intern, return_value, doc, raw TSRMLS_CC)) {
+			goto failure;
+		}
+	}
+
+	php_phongo_cursor_free_session_if_exhausted(intern);
+
+	return;
+
+failure:
+	zval_dtor(return_value);
+	RETVAL_NULL();
 } /* }}} */
 
-/* {{{ proto MongoDB\Driver\Server MongoDB\Driver\Cursor::getServer()
-   Returns the Server object to which this cursor is attached */
-static PHP_METHOD(Cursor, getServer)
+/* Converts a single BSON value for a column built by toColumns(). Numbers,
+ * booleans, strings and nulls are converted directly. Other values are copied
+ * into a single-field wrapper document, which is decoded with the cursor's type
+ * map. Returns false if decoding failed, in which case an exception will have
+ * been thrown and value will be left as null. */
+static bool php_phongo_cursor_iter_to_column_value(php_phongo_cursor_t* cursor, const bson_iter_t* iter, zval* value TSRMLS_DC) /* {{{ */
 {
-	php_phongo_cursor_t* intern;
+	bson_t                wrapper = BSON_INITIALIZER;
+	php_phongo_bson_state state   = PHONGO_BSON_STATE_INITIALIZER;
+	bool                  retval  = false;
+
+	ZVAL_NULL(value);
+
+	switch (bson_iter_type(iter)) {
+		case BSON_TYPE_INT32:
+			ZVAL_LONG(value, bson_iter_int32(iter));
+			return true;
+
+#if SIZEOF_PHONGO_LONG == 8
+		case BSON_TYPE_INT64:
+			if (cursor->visitor_data.map.int64_type != PHONGO_TYPEMAP_LEAF_STRING) {
+				ZVAL_LONG(value, bson_iter_int64(iter));
+				return true;
+			}
+			break;
+#endif
 
-	intern = Z_CURSOR_OBJ_P(getThis());
+		case BSON_TYPE_DOUBLE:
+			ZVAL_DOUBLE(value, bson_iter_double(iter));
+			return true;
 
-	if (zend_parse_parameters_none() == FAILURE) {
-		return;
+		case BSON_TYPE_BOOL:
+			ZVAL_BOOL(value, bson_iter_bool(iter));
+			return true;
+
+		case BSON_TYPE_NULL:
+			return true;
+
+		case BSON_TYPE_UTF8: {
+			uint32_t    len;
+			const char* str = bson_iter_utf8(iter, &len);
+
+#if PHP_VERSION_ID >= 70000
+			ZVAL_STRINGL(value, str, len);
+#else
+			ZVAL_STRINGL(value, str, len, 1);
+#endif
+			return true;
+		}
+
+		default:
+			break;
 	}
 
-	phongo_server_init(return_value, intern->client, intern->server_id TSRMLS_CC);
+	if (!bson_append_iter(&wrapper, "v", 1, iter)) {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Could not copy BSON value");
+		goto cleanup;
+	}
+
+	/* Field paths and projections apply to entire documents, so only the
+	 * cursor's type and leaf type settings are used for the value */
+	state.map      = cursor->visitor_data.map;
+	state.map.root = NULL;
+	memset(&state.map.field_path_map, 0, sizeof(state.map.field_path_map));
+	memset(&state.map.projection_map, 0, sizeof(state.map.projection_map));
+	state.map.field_path_count = 0;
+	state.map.root_type        = PHONGO_TYPEMAP_NATIVE_ARRAY;
+	state.key_cache            = cursor->visitor_data.key_cache;
+
+	if (!php_phongo_bson_to_zval_ex(bson_get_data(&wrapper), wrapper.len, &state)) {
+		zval_ptr_dtor(&state.zchild);
+		goto cleanup;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	{
+		zval* found = zend_hash_str_find(Z_ARRVAL(state.zchild), "v", sizeof("v") - 1);
+
+		if (found) {
+			ZVAL_COPY(value, found);
+		}
+	}
+#else
+	{
+		zval** found;
+
+		if (zend_hash_find(Z_ARRVAL_P(state.zchild), "v", sizeof("v"), (void**) &found) == SUCCESS) {
+			ZVAL_ZVAL(value, *found, 1, 0);
+		}
+	}
+#endif
+
+	zval_ptr_dtor(&state.zchild);
+	retval = true;
+
+cleanup:
+	bson_destroy(&wrapper);
+
+	return retval;
 } /* }}} */
 
-/* {{{ proto boolean MongoDB\Driver\Cursor::isDead()
-   Checks if a cursor is still alive */
-static PHP_METHOD(Cursor, isDead)
+/* Checks that the cursor has not been iterated, which methods consuming the
+ * libmongoc cursor directly require. The method name is used in the exception
+ * message. Throws and returns false otherwise. */
+static bool php_phongo_cursor_check_unused(php_phongo_cursor_t* cursor, const char* method TSRMLS_DC) /* {{{ */
+{
+	if (cursor->got_iterator) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot be consumed by %s() after starting iteration", method);
+		return false;
+	}
+
+	if (cursor->got_batch) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot be consumed by %s() after fetching batches", method);
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
+/* {{{ proto array MongoDB\Driver\Cursor::toColumns(array $fields)
+   Returns an array of columns, each containing a field's value (or null) for
+   all result documents for this cursor */
+static PHP_METHOD(Cursor, toColumns)
 {
 	php_phongo_cursor_t* intern;
+	zval*                fields;
+	HashTable**          columns     = NULL;
+	const char**         paths       = NULL;
+	uint32_t             num_columns = 0;
+	const bson_t*        doc;
+	uint32_t             i;
 
 	intern = Z_CURSOR_OBJ_P(getThis());
 
-	if (zend_parse_parameters_none() == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "a", &fields) == FAILURE) {
 		return;
 	}
 
-	RETURN_BOOL(!mongoc_cursor_more(intern->cursor));
-} /* }}} */
+	if (!php_phongo_cursor_check_unused(intern, "toColumns" TSRMLS_CC)) {
+		return;
+	}
 
-/* {{{ MongoDB\Driver\Cursor function entries */
-ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_setTypeMap, 0, 0, 1)
-	ZEND_ARG_ARRAY_INFO(0, typemap, 0)
-ZEND_END_ARG_INFO()
+	array_init_size(return_value, zend_hash_num_elements(Z_ARRVAL_P(fields)));
 
-ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_void, 0, 0, 0)
-ZEND_END_ARG_INFO()
+	columns = ecalloc(zend_hash_num_elements(Z_ARRVAL_P(fields)) + 1, sizeof(HashTable*));
+	paths   = ecalloc(zend_hash_num_elements(Z_ARRVAL_P(fields)) + 1, sizeof(char*));
 
-static zend_function_entry php_phongo_cursor_me[] = {
-	/* clang-format off */
-	PHP_ME(Cursor, setTypeMap, ai_Cursor_setTypeMap, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	PHP_ME(Cursor, toArray, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	PHP_ME(Cursor, getId, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	PHP_ME(Cursor, getServer, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	PHP_ME(Cursor, isDead, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_Cursor_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
-	ZEND_NAMED_ME(__wakeup, PHP_FN(MongoDB_disabled___wakeup), ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
-	PHP_FE_END
-	/* clang-format on */
-};
-/* }}} */
+	/* Create one column per distinct field path. Paths point into the fields
+	 * array, which outlives this method call. */
+	{
+#if PHP_VERSION_ID >= 70000
+		zval* field;
 
-/* {{{ MongoDB\Driver\Cursor object handlers */
-static zend_object_handlers php_phongo_handler_cursor;
+		ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(fields), field)
+		{
+			zval column;
 
-static void php_phongo_cursor_free_object(phongo_free_object_arg* object TSRMLS_DC) /* {{{ */
-{
-	php_phongo_cursor_t* intern = Z_OBJ_CURSOR(object);
+			ZVAL_DEREF(field);
 
-	zend_object_std_dtor(&intern->std TSRMLS_CC);
+			if (Z_TYPE_P(field) != IS_STRING) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected field path to be a string, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(field));
+				goto failure;
+			}
 
-	if (intern->cursor) {
-		mongoc_cursor_destroy(intern->cursor);
-	}
+			if (zend_symtable_exists(Z_ARRVAL_P(return_value), Z_STR_P(field))) {
+				continue;
+			}
 
-	if (intern->database) {
-		efree(intern->database);
-	}
+			array_init(&column);
+			zend_symtable_update(Z_ARRVAL_P(return_value), Z_STR_P(field), &column);
 
-	if (intern->collection) {
-		efree(intern->collection);
+			columns[num_columns] = Z_ARRVAL(column);
+			paths[num_columns]   = Z_STRVAL_P(field);
+			num_columns++;
+		}
+		ZEND_HASH_FOREACH_END();
+#else
+		HashPosition pos;
+		zval**       field;
+
+		for (
+			zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(fields), &pos);
+			zend_hash_get_current_data_ex(Z_ARRVAL_P(fields), (void**) &field, &pos) == SUCCESS;
+			zend_hash_move_forward_ex(Z_ARRVAL_P(fields), &pos)) {
+			zval* column = NULL;
+
+			if (Z_TYPE_PP(field) != IS_STRING) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected field path to be a string, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME(*field));
+				goto failure;
+			}
+
+			if (zend_symtable_exists(Z_ARRVAL_P(return_value), Z_STRVAL_PP(field), Z_STRLEN_PP(field) + 1)) {
+				continue;
+			}
+
+			MAKE_STD_ZVAL(column);
+			array_init(column);
+			zend_symtable_update(Z_ARRVAL_P(return_value), Z_STRVAL_PP(field), Z_STRLEN_PP(field) + 1, &column, sizeof(zval*), NULL);
+
+			columns[num_columns] = Z_ARRVAL_P(column);
+			paths[num_columns]   = Z_STRVAL_PP(field);
+			num_columns++;
+		}
+#endif
 	}
 
-	if (!Z_ISUNDEF(intern->query)) {
-		zval_ptr_dtor(&intern->query);
-	}
+	/* Documents are consumed directly from the libmongoc cursor, so the
+	 * cursor can no longer be iterated */
+	intern->got_iterator = true;
 
-	if (!Z_ISUNDEF(intern->command)) {
-		zval_ptr_dtor(&intern->command);
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!intern->advanced) {
+		intern->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(intern->cursor TSRMLS_CC)) {
+			/* Exception should already have been thrown */
+			goto failure;
+		}
 	}
 
-	if (!Z_ISUNDEF(intern->read_preference)) {
-		zval_ptr_dtor(&intern->read_preference);
+	doc = mongoc_cursor_current(intern->cursor);
+
+	while (doc) {
+		if (intern->replayable) {
+			php_phongo_cursor_replay_append(intern, doc);
+		}
+
+		for (i = 0; i < num_columns; i++) {
+			bson_iter_t iter;
+			bson_iter_t target;
+			bool        found;
+#if PHP_VERSION_ID >= 70000
+			zval value;
+
+			ZVAL_NULL(&value);
+#else
+			zval* value = NULL;
+
+			MAKE_STD_ZVAL(value);
+			ZVAL_NULL(value);
+#endif
+
+			/* Missing fields are represented by null to keep columns aligned */
+			found = bson_iter_init(&iter, doc) && bson_iter_find_descendant(&iter, paths[i], &target);
+
+#if PHP_VERSION_ID >= 70000
+			if (found && !php_phongo_cursor_iter_to_column_value(intern, &target, &value TSRMLS_CC)) {
+				goto failure;
+			}
+
+			zend_hash_next_index_insert(columns[i], &value);
+#else
+			if (found && !php_phongo_cursor_iter_to_column_value(intern, &target, value TSRMLS_CC)) {
+				zval_ptr_dtor(&value);
+				goto failure;
+			}
+
+			zend_hash_next_index_insert(columns[i], &value, sizeof(zval*), NULL);
+#endif
+		}
+
+		if (!php_phongo_cursor_next(intern, &doc)) {
+			bson_error_t error = { 0 };
+
+			if (EG(exception)) {
+				goto failure;
+			}
+
+			if (mongoc_cursor_error(intern->cursor, &error)) {
+				phongo_throw_exception_from_bson_error_t(&error TSRMLS_CC);
+				goto failure;
+			}
+
+			doc = NULL;
+		}
 	}
 
-	if (!Z_ISUNDEF(intern->session)) {
-		zval_ptr_dtor(&intern->session);
+	php_phongo_cursor_free_session_if_exhausted(intern);
+
+	efree(columns);
+	efree(paths);
+
+	return;
+
+failure:
+	efree(columns);
+	efree(paths);
+	zval_dtor(return_value);
+	RETVAL_NULL();
+} /* }}} */
+
+/* {{{ proto MongoDB\Driver\RecordSet MongoDB\Driver\Cursor::toRecordSet([integer $cacheSize = 0])
+   Consumes the cursor into a RecordSet, which retains each document as raw BSON
+   and only decodes documents as they are accessed */
+static PHP_METHOD(Cursor, toRecordSet)
+{
+	php_phongo_cursor_t* intern;
+	phongo_long          cache_size    = 0;
+	uint8_t*             data          = NULL;
+	size_t               data_len      = 0;
+	size_t               data_alloc    = 0;
+	size_t*              offsets       = NULL;
+	uint32_t             count         = 0;
+	uint32_t             offsets_alloc = 0;
+	const bson_t*        doc;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|l", &cache_size) == FAILURE) {
+		return;
+	}
+
+	if (cache_size < 0) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected cache size to be >= 0, %" PHONGO_LONG_FORMAT " given", cache_size);
+		return;
+	}
+
+	if (!php_phongo_cursor_check_unused(intern, "toRecordSet" TSRMLS_CC)) {
+		return;
+	}
+
+	if (intern->replayable) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Replayable cursors cannot be converted to a RecordSet");
+		return;
+	}
+
+	/* Documents are consumed directly from the libmongoc cursor, so the
+	 * cursor can no longer be iterated */
+	intern->got_iterator = true;
+
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!intern->advanced) {
+		intern->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(intern->cursor TSRMLS_CC)) {
+			/* Exception should already have been thrown */
+			return;
+		}
+	}
+
+	doc = mongoc_cursor_current(intern->cursor);
+
+	/* Documents are copied back to back into a single arena, growing both the
+	 * arena and the offset index geometrically */
+	while (doc) {
+		if (data_len + doc->len > data_alloc) {
+			data_alloc = data_alloc ? data_alloc : 4096;
+
+			while (data_alloc < data_len + doc->len) {
+				data_alloc *= 2;
+			}
+
+			data = erealloc(data, data_alloc);
+		}
+
+		if (count == offsets_alloc) {
+			offsets_alloc = offsets_alloc ? offsets_alloc * 2 : 64;
+			offsets       = erealloc(offsets, offsets_alloc * sizeof(size_t));
+		}
+
+		memcpy(data + data_len, bson_get_data(doc), doc->len);
+		offsets[count++] = data_len;
+		data_len += doc->len;
+
+		if (!php_phongo_cursor_next(intern, &doc)) {
+			bson_error_t error = { 0 };
+
+			if (EG(exception)) {
+				goto failure;
+			}
+
+			if (mongoc_cursor_error(intern->cursor, &error)) {
+				phongo_throw_exception_from_bson_error_t(&error TSRMLS_CC);
+				goto failure;
+			}
+
+			doc = NULL;
+		}
+	}
+
+	php_phongo_cursor_free_session_if_exhausted(intern);
+
+	/* A cache larger than the number of documents would never be filled */
+	if ((uint64_t) cache_size > count) {
+		cache_size = count;
+	}
+
+	/* The RecordSet takes over the type map and key cache, since the cursor
+	 * will not decode any more documents */
+	php_phongo_recordset_init(return_value, data, offsets, count, &intern->visitor_data.map, intern->visitor_data.key_cache, (uint32_t) cache_size TSRMLS_CC);
+
+	memset(&intern->visitor_data.map, 0, sizeof(intern->visitor_data.map));
+	intern->visitor_data.key_cache = NULL;
+
+	return;
+
+failure:
+	if (data) {
+		efree(data);
+	}
+
+	if (offsets) {
+		efree(offsets);
+	}
+} /* }}} */
+
+/* Invokes a callback for each document remaining in the cursor, passing the
+ * decoded document and its position as arguments. Documents are consumed
+ * directly from the libmongoc cursor instead of through the iterator handlers.
+ * If results is not NULL, each return value is appended to it; otherwise,
+ * iteration stops early when the callback returns false. The number of
+ * documents passed to the callback is stored in count. Returns false if an
+ * exception was thrown. */
+static bool php_phongo_cursor_apply_callback(php_phongo_cursor_t* cursor, zend_fcall_info* fci, zend_fcall_info_cache* fcc, zval* results, phongo_long* count TSRMLS_DC) /* {{{ */
+{
+	const bson_t* doc;
+
+	*count = 0;
+
+	/* Documents are consumed directly from the libmongoc cursor, so the
+	 * cursor can no longer be iterated */
+	cursor->got_iterator = true;
+
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!cursor->advanced) {
+		cursor->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(cursor->cursor TSRMLS_CC)) {
+			/* Exception should already have been thrown */
+			return false;
+		}
+	}
+
+	doc = mongoc_cursor_current(cursor->cursor);
+
+	while (doc) {
+		bool stop = false;
+#if PHP_VERSION_ID >= 70000
+		zval args[2];
+		zval retval;
+#else
+		zval** args[2];
+		zval*  document;
+		zval*  key;
+		zval*  retval = NULL;
+#endif
+
+		if (cursor->replayable) {
+			php_phongo_cursor_replay_append(cursor, doc);
+		}
+
+		php_phongo_cursor_decode_current(cursor, doc);
+
+		if (EG(exception)) {
+			return false;
+		}
+
+		/* The callback holds its own reference to the document, since it may
+		 * replace the cursor's current element (e.g. by calling setTypeMap) */
+#if PHP_VERSION_ID >= 70000
+		ZVAL_COPY(&args[0], &cursor->visitor_data.zchild);
+		ZVAL_LONG(&args[1], *count);
+		ZVAL_UNDEF(&retval);
+
+		fci->params      = args;
+		fci->param_count = 2;
+		fci->retval      = &retval;
+
+		if (zend_call_function(fci, fcc) == SUCCESS && !EG(exception) && !Z_ISUNDEF(retval)) {
+			if (results) {
+				add_next_index_zval(results, &retval);
+				ZVAL_UNDEF(&retval);
+			} else {
+				stop = Z_TYPE(retval) == IS_FALSE;
+			}
+		}
+
+		zval_ptr_dtor(&args[0]);
+		zval_ptr_dtor(&retval);
+#else
+		document = cursor->visitor_data.zchild;
+		Z_ADDREF_P(document);
+		MAKE_STD_ZVAL(key);
+		ZVAL_LONG(key, *count);
+
+		args[0] = &document;
+		args[1] = &key;
+
+		fci->params         = args;
+		fci->param_count    = 2;
+		fci->retval_ptr_ptr = &retval;
+
+		if (zend_call_function(fci, fcc TSRMLS_CC) == SUCCESS && !EG(exception) && retval) {
+			if (results) {
+				add_next_index_zval(results, retval);
+				retval = NULL;
+			} else {
+				stop = Z_TYPE_P(retval) == IS_BOOL && !Z_BVAL_P(retval);
+			}
+		}
+
+		zval_ptr_dtor(&document);
+		zval_ptr_dtor(&key);
+
+		if (retval) {
+			zval_ptr_dtor(&retval);
+		}
+#endif
+
+		if (EG(exception)) {
+			return false;
+		}
+
+		(*count)++;
+
+		if (stop) {
+			break;
+		}
+
+		if (!php_phongo_cursor_next(cursor, &doc)) {
+			bson_error_t error = { 0 };
+
+			if (EG(exception)) {
+				return false;
+			}
+
+			if (mongoc_cursor_error(cursor->cursor, &error)) {
+				phongo_throw_exception_from_bson_error_t(&error TSRMLS_CC);
+				return false;
+			}
+
+			doc = NULL;
+		}
+	}
+
+	/* A recycled element is only freed once iteration has finished */
+	php_phongo_cursor_free_current(cursor);
+	php_phongo_cursor_free_session_if_exhausted(cursor);
+
+	return true;
+} /* }}} */
+
+/* {{{ proto integer MongoDB\Driver\Cursor::each(callable $callback)
+   Invokes the callback with each document and its position, stopping early if
+   it returns false. Returns the number of documents passed to the callback. */
+static PHP_METHOD(Cursor, each)
+{
+	php_phongo_cursor_t*  intern;
+	zend_fcall_info       fci = empty_fcall_info;
+	zend_fcall_info_cache fcc = empty_fcall_info_cache;
+	phongo_long           count;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "f", &fci, &fcc) == FAILURE) {
+		return;
+	}
+
+	if (!php_phongo_cursor_check_unused(intern, "each" TSRMLS_CC)) {
+		return;
+	}
+
+	if (!php_phongo_cursor_apply_callback(intern, &fci, &fcc, NULL, &count TSRMLS_CC)) {
+		/* Exception should already have been thrown */
+		return;
+	}
+
+	RETURN_LONG(count);
+} /* }}} */
+
+/* {{{ proto array MongoDB\Driver\Cursor::map(callable $callback)
+   Returns an array of the callback's return values for each document and its
+   position */
+static PHP_METHOD(Cursor, map)
+{
+	php_phongo_cursor_t*  intern;
+	zend_fcall_info       fci = empty_fcall_info;
+	zend_fcall_info_cache fcc = empty_fcall_info_cache;
+	phongo_long           count;
+	int64_t               limit;
+	uint32_t              size;
+	bool                  recycle_documents;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "f", &fci, &fcc) == FAILURE) {
+		return;
+	}
+
+	if (!php_phongo_cursor_check_unused(intern, "map" TSRMLS_CC)) {
+		return;
+	}
+
+	/* The number of results is not known in advance, so the array is sized
+	 * for the cursor's limit if it has one, or its first batch otherwise. A
+	 * negative limit requests a single batch of that many documents. The hint
+	 * is capped so that a large limit on a small result does not allocate
+	 * excessively. */
+	limit = mongoc_cursor_get_limit(intern->cursor);
+	size  = mongoc_cursor_get_batch_size(intern->cursor);
+
+	if (limit != 0) {
+		size = (uint32_t) (limit < 0 ? -limit : limit);
+	}
+
+	array_init_size(return_value, size < 4096 ? size : 4096);
+
+	/* The callback may retain documents in its return values, so none of them
+	 * may be recycled */
+	recycle_documents         = intern->recycle_documents;
+	intern->recycle_documents = false;
+
+	if (!php_phongo_cursor_apply_callback(intern, &fci, &fcc, return_value, &count TSRMLS_CC)) {
+		zval_dtor(return_value);
+		RETVAL_NULL();
+	}
+
+	intern->recycle_documents = recycle_documents;
+} /* }}} */
+
+/* Writes the buffered JSON to the stream and empties the buffer. Returns false
+ * and throws if the stream did not accept all of it. */
+static bool php_phongo_cursor_flush_json(php_stream* stream, bson_string_t* buffer TSRMLS_DC) /* {{{ */
+{
+	if (!buffer->len) {
+		return true;
+	}
+
+	if (php_stream_write(stream, buffer->str, buffer->len) != (size_t) buffer->len) {
+		phongo_throw_exception(PHONGO_ERROR_RUNTIME TSRMLS_CC, "Failed to write JSON to stream");
+		return false;
+	}
+
+	bson_string_truncate(buffer, 0);
+
+	return true;
+} /* }}} */
+
+/* {{{ proto integer MongoDB\Driver\Cursor::exportJSON(resource $stream[, array $options = array()])
+   Writes the extended JSON representation of each remaining document to the
+   stream, either as one document per line or as a JSON array. Documents are
+   converted from raw BSON without being decoded to PHP values. Returns the
+   number of documents written. */
+static PHP_METHOD(Cursor, exportJSON)
+{
+	php_phongo_cursor_t* intern;
+	zval*                zstream;
+	zval*                options = NULL;
+	php_stream*          stream;
+	bool                 canonical = false;
+	bool                 lines     = true;
+	bson_string_t*       buffer;
+	phongo_long          count = 0;
+	const bson_t*        doc;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "r|a!", &zstream, &options) == FAILURE) {
+		return;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	php_stream_from_zval(stream, zstream);
+#else
+	php_stream_from_zval(stream, &zstream);
+#endif
+
+	if (options && php_array_existsc(options, "mode")) {
+		zval* mode = php_array_fetchc(options, "mode");
+
+		if (Z_TYPE_P(mode) == IS_STRING && !strcmp(Z_STRVAL_P(mode), "canonical")) {
+			canonical = true;
+		} else if (Z_TYPE_P(mode) == IS_STRING && !strcmp(Z_STRVAL_P(mode), "relaxed")) {
+			canonical = false;
+		} else {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected \"mode\" option to be \"canonical\" or \"relaxed\"");
+			return;
+		}
+	}
+
+	if (options && php_array_existsc(options, "lines")) {
+		lines = php_array_fetchc_bool(options, "lines");
+	}
+
+	if (!php_phongo_cursor_check_unused(intern, "exportJSON" TSRMLS_CC)) {
+		return;
+	}
+
+	/* Documents are consumed directly from the libmongoc cursor, so the
+	 * cursor can no longer be iterated */
+	intern->got_iterator = true;
+
+	/* If the cursor was never advanced (e.g. command cursor), do so now */
+	if (!intern->advanced) {
+		intern->advanced = true;
+
+		if (!phongo_cursor_advance_and_check_for_error(intern->cursor TSRMLS_CC)) {
+			/* Exception should already have been thrown */
+			return;
+		}
+	}
+
+	buffer = bson_string_new(NULL);
+
+	if (!lines) {
+		bson_string_append_c(buffer, '[');
+	}
+
+	doc = mongoc_cursor_current(intern->cursor);
+
+	while (doc) {
+		char*  json;
+		size_t json_len;
+
+		if (intern->replayable) {
+			php_phongo_cursor_replay_append(intern, doc);
+		}
+
+		if (canonical) {
+			json = bson_as_canonical_extended_json(doc, &json_len);
+		} else {
+			json = bson_as_relaxed_extended_json(doc, &json_len);
+		}
+
+		if (!json) {
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Could not convert BSON document to a JSON string");
+			goto cleanup;
+		}
+
+		if (!lines && count > 0) {
+			bson_string_append_c(buffer, ',');
+		}
+
+		bson_string_append(buffer, json);
+		bson_free(json);
+
+		if (lines) {
+			bson_string_append_c(buffer, '\n');
+		}
+
+		count++;
+
+		if (buffer->len >= PHONGO_EXPORT_JSON_CHUNK_SIZE && !php_phongo_cursor_flush_json(stream, buffer TSRMLS_CC)) {
+			goto cleanup;
+		}
+
+		if (!php_phongo_cursor_next(intern, &doc)) {
+			bson_error_t error = { 0 };
+
+			if (EG(exception)) {
+				goto cleanup;
+			}
+
+			if (mongoc_cursor_error(intern->cursor, &error)) {
+				phongo_throw_exception_from_bson_error_t(&error TSRMLS_CC);
+				goto cleanup;
+			}
+
+			doc = NULL;
+		}
+	}
+
+	php_phongo_cursor_free_session_if_exhausted(intern);
+
+	if (!lines) {
+		bson_string_append_c(buffer, ']');
+	}
+
+	if (php_phongo_cursor_flush_json(stream, buffer TSRMLS_CC)) {
+		RETVAL_LONG(count);
+	}
+
+cleanup:
+	bson_string_free(buffer, true);
+} /* }}} */
+
+/* {{{ proto void MongoDB\Driver\Cursor::setDocumentRecycling(boolean $recycle)
+   Sets whether iteration may overwrite the previous document in place, unless
+   it is still referenced outside of the loop */
+static PHP_METHOD(Cursor, setDocumentRecycling)
+{
+	php_phongo_cursor_t* intern;
+	zend_bool            recycle;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "b", &recycle) == FAILURE) {
+		return;
+	}
+
+	intern->recycle_documents = recycle;
+} /* }}} */
+
+/* {{{ proto void MongoDB\Driver\Cursor::setReplayable(boolean $replayable)
+   Sets whether consumed documents are retained as raw BSON, which allows the
+   cursor to be rewound and iterated again */
+static PHP_METHOD(Cursor, setReplayable)
+{
+	php_phongo_cursor_t* intern;
+	zend_bool            replayable;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "b", &replayable) == FAILURE) {
+		return;
+	}
+
+	if (intern->got_iterator || intern->got_batch) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors cannot change replay mode after starting iteration");
+		return;
+	}
+
+	intern->replayable = replayable;
+} /* }}} */
+
+/* {{{ proto void MongoDB\Driver\Cursor::setAdaptiveBatchSize(integer $targetBytes)
+   Sets a byte budget from which the batch size of each getMore is derived,
+   based on the average size of documents consumed so far. Zero disables
+   adaptive batch sizing, leaving the last batch size in effect. */
+static PHP_METHOD(Cursor, setAdaptiveBatchSize)
+{
+	php_phongo_cursor_t* intern;
+	phongo_long          target_bytes;
+	const bson_t*        doc;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l", &target_bytes) == FAILURE) {
+		return;
+	}
+
+	if (target_bytes < 0 || target_bytes > INT32_MAX) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected target bytes to be >= 0 and <= %" PRId32 ", %" PHONGO_LONG_FORMAT " given", INT32_MAX, target_bytes);
+		return;
+	}
+
+	/* The current document was not observed if adaptive batch sizing was
+	 * previously disabled */
+	if (!intern->adaptive_batch_bytes && target_bytes && (doc = mongoc_cursor_current(intern->cursor))) {
+		php_phongo_cursor_observe_document(intern, doc);
+	}
+
+	intern->adaptive_batch_bytes = (uint32_t) target_bytes;
+} /* }}} */
+
+/* {{{ proto string MongoDB\Driver\Cursor::detach()
+   Returns a token with which a later request in this process may attach to the
+   server cursor, which is retained instead of killed when this Cursor is freed */
+static PHP_METHOD(Cursor, detach)
+{
+	php_phongo_cursor_t* intern;
+	bson_oid_t           oid;
+	char                 token[25];
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	if (intern->detach_token) {
+		PHONGO_RETURN_STRING(intern->detach_token);
+	}
+
+	/* A session is freed along with the request that started it, so its
+	 * cursors cannot outlive the request */
+	if (!Z_ISUNDEF(intern->session)) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors using a session cannot be detached");
+		return;
+	}
+
+	if (!mongoc_cursor_get_id(intern->cursor)) {
+		phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "Cursors that are exhausted cannot be detached");
+		return;
+	}
+
+	bson_oid_init(&oid, NULL);
+	bson_oid_to_string(&oid, token);
+
+	intern->detach_token = estrdup(token);
+
+	PHONGO_RETURN_STRING(intern->detach_token);
+} /* }}} */
+
+/* {{{ proto MongoDB\Driver\CursorId MongoDB\Driver\Cursor::getId()
+   Returns the CursorId for this cursor */
+static PHP_METHOD(Cursor, getId)
+{
+	php_phongo_cursor_t* intern;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	php_phongo_cursor_id_new_from_id(return_value, mongoc_cursor_get_id(intern->cursor) TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto MongoDB\Driver\Server MongoDB\Driver\Cursor::getServer()
+   Returns the Server object to which this cursor is attached */
+static PHP_METHOD(Cursor, getServer)
+{
+	php_phongo_cursor_t* intern;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	phongo_server_init(return_value, intern->client, intern->server_id TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\Driver\Cursor::isDead()
+   Checks if a cursor is still alive */
+static PHP_METHOD(Cursor, isDead)
+{
+	php_phongo_cursor_t* intern;
+
+	intern = Z_CURSOR_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	RETURN_BOOL(!mongoc_cursor_more(intern->cursor));
+} /* }}} */
+
+/* {{{ MongoDB\Driver\Cursor function entries */
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_setTypeMap, 0, 0, 1)
+	ZEND_ARG_ARRAY_INFO(0, typemap, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_nextBatch, 0, 0, 0)
+	ZEND_ARG_INFO(0, raw)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_toColumns, 0, 0, 1)
+	ZEND_ARG_ARRAY_INFO(0, fields, 0)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_toRecordSet, 0, 0, 0)
+	ZEND_ARG_INFO(0, cacheSize)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_callback, 0, 0, 1)
+	ZEND_ARG_INFO(0, callback)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_exportJSON, 0, 0, 1)
+	ZEND_ARG_INFO(0, stream)
+	ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_setDocumentRecycling, 0, 0, 1)
+	ZEND_ARG_INFO(0, recycle)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_setReplayable, 0, 0, 1)
+	ZEND_ARG_INFO(0, replayable)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_setAdaptiveBatchSize, 0, 0, 1)
+	ZEND_ARG_INFO(0, targetBytes)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_Cursor_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_cursor_me[] = {
+	/* clang-format off */
+	PHP_ME(Cursor, setTypeMap, ai_Cursor_setTypeMap, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, toArray, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, toColumns, ai_Cursor_toColumns, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, toRecordSet, ai_Cursor_toRecordSet, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, each, ai_Cursor_callback, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, map, ai_Cursor_callback, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, exportJSON, ai_Cursor_exportJSON, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, nextBatch, ai_Cursor_nextBatch, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, setDocumentRecycling, ai_Cursor_setDocumentRecycling, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, setReplayable, ai_Cursor_setReplayable, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, setAdaptiveBatchSize, ai_Cursor_setAdaptiveBatchSize, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, detach, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, getId, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, getServer, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Cursor, isDead, ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_Cursor_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__wakeup, PHP_FN(MongoDB_disabled___wakeup), ai_Cursor_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_FE_END
+	/* clang-format on */
+};
+/* }}} */
+
+/* {{{ MongoDB\Driver\Cursor object handlers */
+static zend_object_handlers php_phongo_handler_cursor;
+
+static void php_phongo_cursor_free_object(phongo_free_object_arg* object TSRMLS_DC) /* {{{ */
+{
+	php_phongo_cursor_t* intern = Z_OBJ_CURSOR(object);
+
+	zend_object_std_dtor(&intern->std TSRMLS_CC);
+
+	/* A detached cursor that the server has not exhausted is retained for a
+	 * later request instead of being destroyed */
+	if (intern->detach_token) {
+		if (intern->cursor && mongoc_cursor_get_id(intern->cursor)) {
+			phongo_cursor_detach(intern, intern->detach_token TSRMLS_CC);
+		}
+
+		efree(intern->detach_token);
+	}
+
+	if (intern->cursor) {
+		mongoc_cursor_destroy(intern->cursor);
+	}
+
+	if (intern->database) {
+		efree(intern->database);
+	}
+
+	if (intern->collection) {
+		efree(intern->collection);
+	}
+
+	if (!Z_ISUNDEF(intern->query)) {
+		zval_ptr_dtor(&intern->query);
+	}
+
+	if (!Z_ISUNDEF(intern->command)) {
+		zval_ptr_dtor(&intern->command);
+	}
+
+	if (!Z_ISUNDEF(intern->read_preference)) {
+		zval_ptr_dtor(&intern->read_preference);
+	}
+
+	if (!Z_ISUNDEF(intern->session)) {
+		zval_ptr_dtor(&intern->session);
+	}
+
+	if (intern->replay_buffer) {
+		efree(intern->replay_buffer);
 	}
 
 	php_phongo_bson_typemap_dtor(&intern->visitor_data.map);
 
 	php_phongo_cursor_free_current(intern);
+	php_phongo_bson_state_key_cache_dtor(&intern->visitor_data);
 
 #if PHP_VERSION_ID < 70000
 	efree(intern);
@@ -525,6 +525,24 @@ cleanup:
 	}
 } /* }}} */
 
+/* {{{ proto MongoDB\Driver\Cursor MongoDB\Driver\Manager::attachCursor(string $token)
+   Returns a Cursor for a server cursor detached by a previous request */
+static PHP_METHOD(Manager, attachCursor)
+{
+	php_phongo_manager_t* intern;
+	char*                 token;
+	phongo_zpp_char_len   token_len;
+
+	intern = Z_MANAGER_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s", &token, &token_len) == FAILURE) {
+		return;
+	}
+
+	/* Exception should already have been thrown on failure */
+	phongo_cursor_attach(return_value, intern->client, token, token_len TSRMLS_CC);
+} /* }}} */
+
 /* {{{ proto MongoDB\Driver\ReadConcern MongoDB\Driver\Manager::getReadConcern()
    Returns the ReadConcern associated with this Manager */
 static PHP_METHOD(Manager, getReadConcern)
@@ -735,6 +753,10 @@ ZEND_BEGIN_ARG_INFO_EX(ai_Manager_executeBulkWrite, 0, 0, 2)
 	ZEND_ARG_INFO(0, options)
 ZEND_END_ARG_INFO()
 
+ZEND_BEGIN_ARG_INFO_EX(ai_Manager_attachCursor, 0, 0, 1)
+	ZEND_ARG_INFO(0, token)
+ZEND_END_ARG_INFO()
+
 ZEND_BEGIN_ARG_INFO_EX(ai_Manager_selectServer, 0, 0, 1)
 	ZEND_ARG_OBJ_INFO(0, readPreference, MongoDB\\Driver\\ReadPreference, 1)
 ZEND_END_ARG_INFO()
@@ -755,6 +777,7 @@ static zend_function_entry php_phongo_manager_me[] = {
 	PHP_ME(Manager, executeReadWriteCommand, ai_Manager_executeCommand, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Manager, executeQuery, ai_Manager_executeQuery, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Manager, executeBulkWrite, ai_Manager_executeBulkWrite, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(Manager, attachCursor, ai_Manager_attachCursor, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Manager, getReadConcern, ai_Manager_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Manager, getReadPreference, ai_Manager_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
 	PHP_ME(Manager, getServers, ai_Manager_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
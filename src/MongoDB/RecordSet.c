@@ -0,0 +1,539 @@
+/*
+ * Copyright 2014-2017 MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <php.h>
+#include <Zend/zend_interfaces.h>
+#include <ext/spl/spl_iterators.h>
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "phongo_compat.h"
+#include "php_phongo.h"
+#include "php_bson.h"
+
+zend_class_entry* php_phongo_recordset_ce;
+
+/* Returns whether a decoded row may be shared between reads. Arrays are
+ * separated when they are modified and the BSON type classes are immutable,
+ * but other objects (e.g. stdClass or classes from the type map) could be
+ * modified through any reference to them. */
+static bool php_phongo_recordset_is_shareable(zval* value TSRMLS_DC) /* {{{ */
+{
+	if (Z_TYPE_P(value) == IS_OBJECT) {
+		zend_class_entry* ce = Z_OBJCE_P(value);
+
+		return ce->type == ZEND_INTERNAL_CLASS && (instanceof_function(ce, php_phongo_type_ce TSRMLS_CC) || ce == php_phongo_date_immutable_ce);
+	}
+
+	if (Z_TYPE_P(value) == IS_ARRAY) {
+#if PHP_VERSION_ID >= 70000
+		zval* entry;
+
+		ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(value), entry)
+		{
+			if (!php_phongo_recordset_is_shareable(entry)) {
+				return false;
+			}
+		}
+		ZEND_HASH_FOREACH_END();
+#else
+		HashPosition pos;
+		zval**       entry;
+
+		for (
+			zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(value), &pos);
+			zend_hash_get_current_data_ex(Z_ARRVAL_P(value), (void**) &entry, &pos) == SUCCESS;
+			zend_hash_move_forward_ex(Z_ARRVAL_P(value), &pos)) {
+
+			if (!php_phongo_recordset_is_shareable(*entry TSRMLS_CC)) {
+				return false;
+			}
+		}
+#endif
+	}
+
+	return true;
+} /* }}} */
+
+/* Decodes the document at the given index into the value argument, which must
+ * already be allocated. If a row cache was requested, a hit is copied from the
+ * cache and a miss replaces the row occupying the index's slot. Only rows that
+ * can be shared between reads are cached; other rows are decoded each time.
+ * Returns false if decoding failed, in which case an exception will have been
+ * thrown. */
+static bool php_phongo_recordset_decode(php_phongo_recordset_t* intern, uint32_t index, zval* value TSRMLS_DC) /* {{{ */
+{
+	php_phongo_bson_state state = PHONGO_BSON_STATE_INITIALIZER;
+	uint32_t              slot  = 0;
+	uint32_t              len;
+
+	if (intern->cache_size) {
+		slot = index % intern->cache_size;
+
+		if (intern->cache_rows[slot] == index + 1) {
+#if PHP_VERSION_ID >= 70000
+			ZVAL_COPY(value, &intern->cache[slot]);
+#else
+			ZVAL_ZVAL(value, intern->cache[slot], 1, 0);
+#endif
+			return true;
+		}
+	}
+
+	memcpy(&len, intern->data + intern->offsets[index], sizeof(len));
+
+	/* Decoding uses the type map and key cache taken from the cursor */
+	state.map       = intern->map;
+	state.key_cache = intern->key_cache;
+
+	if (!php_phongo_bson_to_zval_ex(intern->data + intern->offsets[index], BSON_UINT32_FROM_LE(len), &state)) {
+		zval_ptr_dtor(&state.zchild);
+		return false;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	ZVAL_COPY_VALUE(value, &state.zchild);
+#else
+	ZVAL_ZVAL(value, state.zchild, 0, 1);
+#endif
+
+	if (intern->cache_size && php_phongo_recordset_is_shareable(value TSRMLS_CC)) {
+		if (!Z_ISUNDEF(intern->cache[slot])) {
+			zval_ptr_dtor(&intern->cache[slot]);
+		}
+
+#if PHP_VERSION_ID >= 70000
+		ZVAL_COPY(&intern->cache[slot], value);
+#else
+		MAKE_STD_ZVAL(intern->cache[slot]);
+		ZVAL_ZVAL(intern->cache[slot], value, 1, 0);
+#endif
+		intern->cache_rows[slot] = index + 1;
+	}
+
+	return true;
+} /* }}} */
+
+/* Initializes a RecordSet from the raw BSON documents consumed by a cursor.
+ * The RecordSet takes ownership of the data and offsets buffers, as well as the
+ * type map and key cache, which the caller must no longer reference. */
+void php_phongo_recordset_init(zval* object, uint8_t* data, size_t* offsets, uint32_t count, php_phongo_bson_typemap* map, HashTable* key_cache, uint32_t cache_size TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_t* intern;
+
+	object_init_ex(object, php_phongo_recordset_ce);
+
+	intern             = Z_RECORDSET_OBJ_P(object);
+	intern->data       = data;
+	intern->offsets    = offsets;
+	intern->count      = count;
+	intern->map        = *map;
+	intern->key_cache  = key_cache;
+	intern->cache_size = cache_size;
+
+	if (intern->cache_size) {
+		intern->cache      = ecalloc(intern->cache_size, sizeof(*intern->cache));
+		intern->cache_rows = ecalloc(intern->cache_size, sizeof(*intern->cache_rows));
+	}
+} /* }}} */
+
+/* Parses an ArrayAccess offset and checks that it refers to a row. If the
+ * offset is out of range and throw_on_error is true, an exception is thrown. */
+static bool php_phongo_recordset_parse_offset(php_phongo_recordset_t* intern, zval* offset, uint32_t* index, bool throw_on_error TSRMLS_DC) /* {{{ */
+{
+	phongo_long value;
+
+	if (Z_TYPE_P(offset) == IS_LONG) {
+		value = Z_LVAL_P(offset);
+	} else if (Z_TYPE_P(offset) == IS_STRING && is_numeric_string(Z_STRVAL_P(offset), Z_STRLEN_P(offset), &value, NULL, 0) == IS_LONG) {
+		/* Numeric strings are accepted like array keys */
+	} else {
+		if (throw_on_error) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected offset to be an integer, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(offset));
+		}
+		return false;
+	}
+
+	if (value < 0 || value >= (phongo_long) intern->count) {
+		if (throw_on_error) {
+			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Offset %" PHONGO_LONG_FORMAT " is out of range", value);
+		}
+		return false;
+	}
+
+	*index = (uint32_t) value;
+
+	return true;
+} /* }}} */
+
+/* {{{ proto integer MongoDB\Driver\RecordSet::count()
+   Returns the number of documents in the RecordSet */
+static PHP_METHOD(RecordSet, count)
+{
+	php_phongo_recordset_t* intern;
+
+	intern = Z_RECORDSET_OBJ_P(getThis());
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	RETURN_LONG(intern->count);
+} /* }}} */
+
+/* {{{ proto boolean MongoDB\Driver\RecordSet::offsetExists(mixed $offset)
+   Returns whether a document exists at the offset */
+static PHP_METHOD(RecordSet, offsetExists)
+{
+	php_phongo_recordset_t* intern;
+	zval*                   offset;
+	uint32_t                index;
+
+	intern = Z_RECORDSET_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &offset) == FAILURE) {
+		return;
+	}
+
+	RETURN_BOOL(php_phongo_recordset_parse_offset(intern, offset, &index, false TSRMLS_CC));
+} /* }}} */
+
+/* {{{ proto mixed MongoDB\Driver\RecordSet::offsetGet(mixed $offset)
+   Decodes and returns the document at the offset */
+static PHP_METHOD(RecordSet, offsetGet)
+{
+	php_phongo_recordset_t* intern;
+	zval*                   offset;
+	uint32_t                index;
+
+	intern = Z_RECORDSET_OBJ_P(getThis());
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &offset) == FAILURE) {
+		return;
+	}
+
+	if (!php_phongo_recordset_parse_offset(intern, offset, &index, true TSRMLS_CC)) {
+		return;
+	}
+
+	/* Exception should already have been thrown if decoding fails */
+	php_phongo_recordset_decode(intern, index, return_value TSRMLS_CC);
+} /* }}} */
+
+/* {{{ proto void MongoDB\Driver\RecordSet::offsetSet(mixed $offset, mixed $value)
+   RecordSets are immutable */
+static PHP_METHOD(RecordSet, offsetSet)
+{
+	zval* offset;
+	zval* value;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "zz", &offset, &value) == FAILURE) {
+		return;
+	}
+
+	phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "MongoDB\\Driver\\RecordSet is immutable");
+} /* }}} */
+
+/* {{{ proto void MongoDB\Driver\RecordSet::offsetUnset(mixed $offset)
+   RecordSets are immutable */
+static PHP_METHOD(RecordSet, offsetUnset)
+{
+	zval* offset;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z", &offset) == FAILURE) {
+		return;
+	}
+
+	phongo_throw_exception(PHONGO_ERROR_LOGIC TSRMLS_CC, "MongoDB\\Driver\\RecordSet is immutable");
+} /* }}} */
+
+/* {{{ MongoDB\Driver\RecordSet function entries */
+ZEND_BEGIN_ARG_INFO_EX(ai_RecordSet_offset, 0, 0, 1)
+	ZEND_ARG_INFO(0, offset)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_RecordSet_offsetSet, 0, 0, 2)
+	ZEND_ARG_INFO(0, offset)
+	ZEND_ARG_INFO(0, value)
+ZEND_END_ARG_INFO()
+
+ZEND_BEGIN_ARG_INFO_EX(ai_RecordSet_void, 0, 0, 0)
+ZEND_END_ARG_INFO()
+
+static zend_function_entry php_phongo_recordset_me[] = {
+	/* clang-format off */
+	PHP_ME(RecordSet, count, ai_RecordSet_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(RecordSet, offsetExists, ai_RecordSet_offset, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(RecordSet, offsetGet, ai_RecordSet_offset, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(RecordSet, offsetSet, ai_RecordSet_offsetSet, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_ME(RecordSet, offsetUnset, ai_RecordSet_offset, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__construct, PHP_FN(MongoDB_disabled___construct), ai_RecordSet_void, ZEND_ACC_PRIVATE | ZEND_ACC_FINAL)
+	ZEND_NAMED_ME(__wakeup, PHP_FN(MongoDB_disabled___wakeup), ai_RecordSet_void, ZEND_ACC_PUBLIC | ZEND_ACC_FINAL)
+	PHP_FE_END
+	/* clang-format on */
+};
+/* }}} */
+
+/* {{{ MongoDB\Driver\RecordSet iterator handlers */
+static void php_phongo_recordset_iterator_free_current(php_phongo_recordset_iterator* recordset_it) /* {{{ */
+{
+	if (!Z_ISUNDEF(recordset_it->current)) {
+		zval_ptr_dtor(&recordset_it->current);
+		ZVAL_UNDEF(&recordset_it->current);
+	}
+} /* }}} */
+
+static void php_phongo_recordset_iterator_dtor(zend_object_iterator* iter TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	php_phongo_recordset_iterator_free_current(recordset_it);
+
+	if (!Z_ISUNDEF(recordset_it->intern.data)) {
+#if PHP_VERSION_ID >= 70000
+		zval_ptr_dtor(&recordset_it->intern.data);
+#else
+		zval_ptr_dtor((zval**) &recordset_it->intern.data);
+		recordset_it->intern.data = NULL;
+#endif
+	}
+
+#if PHP_VERSION_ID < 70000
+	efree(recordset_it);
+#endif
+} /* }}} */
+
+static int php_phongo_recordset_iterator_valid(zend_object_iterator* iter TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	return recordset_it->position < recordset_it->recordset->count ? SUCCESS : FAILURE;
+} /* }}} */
+
+static void php_phongo_recordset_iterator_get_current_key(zend_object_iterator* iter, zval* key TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	ZVAL_LONG(key, recordset_it->position);
+} /* }}} */
+
+/* The current document is only decoded once it is requested, so iterating
+ * keys alone does not decode any documents */
+#if PHP_VERSION_ID < 70000
+static void php_phongo_recordset_iterator_get_current_data(zend_object_iterator* iter, zval*** data TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	if (Z_ISUNDEF(recordset_it->current)) {
+		MAKE_STD_ZVAL(recordset_it->current);
+		ZVAL_NULL(recordset_it->current);
+
+		php_phongo_recordset_decode(recordset_it->recordset, recordset_it->position, recordset_it->current TSRMLS_CC);
+	}
+
+	*data = &recordset_it->current;
+} /* }}} */
+#else
+static zval* php_phongo_recordset_iterator_get_current_data(zend_object_iterator* iter) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	if (Z_ISUNDEF(recordset_it->current) && !php_phongo_recordset_decode(recordset_it->recordset, recordset_it->position, &recordset_it->current)) {
+		ZVAL_NULL(&recordset_it->current);
+	}
+
+	return &recordset_it->current;
+} /* }}} */
+#endif
+
+static void php_phongo_recordset_iterator_move_forward(zend_object_iterator* iter TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	php_phongo_recordset_iterator_free_current(recordset_it);
+	recordset_it->position++;
+} /* }}} */
+
+static void php_phongo_recordset_iterator_rewind(zend_object_iterator* iter TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = (php_phongo_recordset_iterator*) iter;
+
+	php_phongo_recordset_iterator_free_current(recordset_it);
+	recordset_it->position = 0;
+} /* }}} */
+
+static zend_object_iterator_funcs php_phongo_recordset_iterator_funcs = {
+	php_phongo_recordset_iterator_dtor,
+	php_phongo_recordset_iterator_valid,
+	php_phongo_recordset_iterator_get_current_data,
+	php_phongo_recordset_iterator_get_current_key,
+	php_phongo_recordset_iterator_move_forward,
+	php_phongo_recordset_iterator_rewind,
+	NULL /* invalidate_current is not used */
+};
+
+static zend_object_iterator* php_phongo_recordset_get_iterator(zend_class_entry* ce, zval* object, int by_ref TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_iterator* recordset_it = NULL;
+
+	if (by_ref) {
+		zend_error(E_ERROR, "An iterator cannot be used with foreach by reference");
+	}
+
+	recordset_it = ecalloc(1, sizeof(php_phongo_recordset_iterator));
+#if PHP_VERSION_ID >= 70000
+	zend_iterator_init(&recordset_it->intern);
+#endif
+
+#if PHP_VERSION_ID >= 70000
+	ZVAL_COPY(&recordset_it->intern.data, object);
+#else
+	Z_ADDREF_P(object);
+	recordset_it->intern.data = (void*) object;
+#endif
+	recordset_it->intern.funcs = &php_phongo_recordset_iterator_funcs;
+	recordset_it->recordset    = Z_RECORDSET_OBJ_P(object);
+	/* recordset_it->position and current should already be zeroed */
+
+	return &recordset_it->intern;
+} /* }}} */
+/* }}} */
+
+/* {{{ MongoDB\Driver\RecordSet object handlers */
+static zend_object_handlers php_phongo_handler_recordset;
+
+static void php_phongo_recordset_free_object(phongo_free_object_arg* object TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_t* intern = Z_OBJ_RECORDSET(object);
+	uint32_t                i;
+
+	zend_object_std_dtor(&intern->std TSRMLS_CC);
+
+	if (intern->data) {
+		efree(intern->data);
+	}
+
+	if (intern->offsets) {
+		efree(intern->offsets);
+	}
+
+	if (intern->cache) {
+		for (i = 0; i < intern->cache_size; i++) {
+			if (!Z_ISUNDEF(intern->cache[i])) {
+				zval_ptr_dtor(&intern->cache[i]);
+			}
+		}
+
+		efree(intern->cache);
+		efree(intern->cache_rows);
+	}
+
+	php_phongo_bson_typemap_dtor(&intern->map);
+
+	if (intern->key_cache) {
+		zend_hash_destroy(intern->key_cache);
+		FREE_HASHTABLE(intern->key_cache);
+	}
+
+#if PHP_VERSION_ID < 70000
+	efree(intern);
+#endif
+} /* }}} */
+
+static phongo_create_object_retval php_phongo_recordset_create_object(zend_class_entry* class_type TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_t* intern = NULL;
+
+	intern = PHONGO_ALLOC_OBJECT_T(php_phongo_recordset_t, class_type);
+
+	zend_object_std_init(&intern->std, class_type TSRMLS_CC);
+	object_properties_init(&intern->std, class_type);
+
+#if PHP_VERSION_ID >= 70000
+	intern->std.handlers = &php_phongo_handler_recordset;
+
+	return &intern->std;
+#else
+	{
+		zend_object_value retval;
+		retval.handle   = zend_objects_store_put(intern, (zend_objects_store_dtor_t) zend_objects_destroy_object, php_phongo_recordset_free_object, NULL TSRMLS_CC);
+		retval.handlers = &php_phongo_handler_recordset;
+
+		return retval;
+	}
+#endif
+} /* }}} */
+
+static HashTable* php_phongo_recordset_get_debug_info(zval* object, int* is_temp TSRMLS_DC) /* {{{ */
+{
+	php_phongo_recordset_t* intern;
+	zval                    retval = ZVAL_STATIC_INIT;
+	size_t                  data_len;
+
+	*is_temp = 1;
+	intern   = Z_RECORDSET_OBJ_P(object);
+
+	array_init_size(&retval, 3);
+
+	/* The last document ends where the data buffer ends */
+	if (intern->count) {
+		uint32_t len;
+
+		memcpy(&len, intern->data + intern->offsets[intern->count - 1], sizeof(len));
+		data_len = intern->offsets[intern->count - 1] + BSON_UINT32_FROM_LE(len);
+	} else {
+		data_len = 0;
+	}
+
+	ADD_ASSOC_LONG_EX(&retval, "count", intern->count);
+	ADD_ASSOC_LONG_EX(&retval, "dataLength", data_len);
+	ADD_ASSOC_LONG_EX(&retval, "cacheSize", intern->cache_size);
+
+	return Z_ARRVAL(retval);
+} /* }}} */
+/* }}} */
+
+void php_phongo_recordset_init_ce(INIT_FUNC_ARGS) /* {{{ */
+{
+	zend_class_entry ce;
+
+	INIT_NS_CLASS_ENTRY(ce, "MongoDB\\Driver", "RecordSet", php_phongo_recordset_me);
+	php_phongo_recordset_ce                = zend_register_internal_class(&ce TSRMLS_CC);
+	php_phongo_recordset_ce->create_object = php_phongo_recordset_create_object;
+	PHONGO_CE_FINAL(php_phongo_recordset_ce);
+	PHONGO_CE_DISABLE_SERIALIZATION(php_phongo_recordset_ce);
+	php_phongo_recordset_ce->get_iterator = php_phongo_recordset_get_iterator;
+
+	zend_class_implements(php_phongo_recordset_ce TSRMLS_CC, 3, zend_ce_traversable, zend_ce_arrayaccess, spl_ce_Countable);
+
+	memcpy(&php_phongo_handler_recordset, phongo_get_std_object_handlers(), sizeof(zend_object_handlers));
+	php_phongo_handler_recordset.get_debug_info = php_phongo_recordset_get_debug_info;
+#if PHP_VERSION_ID >= 70000
+	php_phongo_handler_recordset.free_obj = php_phongo_recordset_free_object;
+	php_phongo_handler_recordset.offset   = XtOffsetOf(php_phongo_recordset_t, std);
+#endif
+} /* }}} */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4
+ */
@@ -45,8 +45,190 @@
 #undef MONGOC_LOG_DOMAIN
 #define MONGOC_LOG_DOMAIN "PHONGO-BSON"
 
+#if PHP_VERSION_ID >= 70000
+/* Packed arrays without holes have sequential integer keys starting at zero,
+ * so they can be identified as lists without inspecting their keys. */
+#define PHONGO_HT_IS_LIST(ht) (((ht)->u.flags & HASH_FLAG_PACKED) && (ht)->nNumUsed == (ht)->nNumOfElements)
+#endif
+
+ZEND_EXTERN_MODULE_GLOBALS(mongodb)
+
+/* Returns whether a PHP string is valid UTF-8 for BSON, which also permits the
+ * overlong two-byte form of NUL. On PHP 7.3+, strings without NUL in either
+ * form are flagged with IS_STR_VALID_UTF8 (as ext/pcre does), so strings that
+ * are encoded repeatedly are only validated once. The flag is trusted by other
+ * extensions, so it is never set for a string containing an overlong NUL. */
+static bool php_phongo_zval_is_utf8(zval* entry) /* {{{ */
+{
+#ifdef IS_STR_VALID_UTF8
+	zend_string* str = Z_STR_P(entry);
+
+	if (GC_FLAGS(str) & IS_STR_VALID_UTF8) {
+		return true;
+	}
+
+	if (!php_phongo_bson_utf8_validate(ZSTR_VAL(str), ZSTR_LEN(str), false)) {
+		return php_phongo_bson_utf8_validate(ZSTR_VAL(str), ZSTR_LEN(str), true);
+	}
+
+	if (!ZSTR_IS_INTERNED(str)) {
+		GC_ADD_FLAGS(str, IS_STR_VALID_UTF8);
+	}
+
+	return true;
+#else
+	return php_phongo_bson_utf8_validate(Z_STRVAL_P(entry), Z_STRLEN_P(entry), true);
+#endif
+} /* }}} */
+
+/* Objects are encoded according to a descriptor that is computed once per
+ * class and request. This avoids probing each object for the interfaces and
+ * BSON types that the driver supports. */
+typedef enum {
+	PHONGO_BSON_ENCODE_PROPERTIES,
+	PHONGO_BSON_ENCODE_CURSORID,
+	PHONGO_BSON_ENCODE_SERIALIZABLE,
+	PHONGO_BSON_ENCODE_DOCUMENT,
+	PHONGO_BSON_ENCODE_OBJECTID,
+	PHONGO_BSON_ENCODE_UTCDATETIME,
+	PHONGO_BSON_ENCODE_BINARY,
+	PHONGO_BSON_ENCODE_DECIMAL128,
+	PHONGO_BSON_ENCODE_INT64,
+	PHONGO_BSON_ENCODE_REGEX,
+	PHONGO_BSON_ENCODE_JAVASCRIPT,
+	PHONGO_BSON_ENCODE_TIMESTAMP,
+	PHONGO_BSON_ENCODE_MAXKEY,
+	PHONGO_BSON_ENCODE_MINKEY,
+	PHONGO_BSON_ENCODE_DBPOINTER,
+	PHONGO_BSON_ENCODE_SYMBOL,
+	PHONGO_BSON_ENCODE_UNDEFINED,
+	PHONGO_BSON_ENCODE_UNKNOWN_TYPE
+} php_phongo_bson_encode_kind_t;
+
+typedef struct {
+	php_phongo_bson_encode_kind_t kind;
+	bool                          is_persistable;
+} php_phongo_bson_encode_class_t;
+
+/* Instances of BSON types (other than Serializable) are encoded from their
+ * internal state, so they cannot contain other values */
+#define PHONGO_BSON_ENCODE_IS_LEAF(desc) ((desc)->kind != PHONGO_BSON_ENCODE_PROPERTIES && (desc)->kind != PHONGO_BSON_ENCODE_SERIALIZABLE)
+
 /* Forwards declarations */
 static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, bson_t* bson, bson_t** bson_out TSRMLS_DC);
+static void php_phongo_bson_append(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, const char* key, long key_len, zval* entry TSRMLS_DC);
+
+static php_phongo_bson_encode_kind_t php_phongo_bson_encode_kind(zend_class_entry* ce TSRMLS_DC) /* {{{ */
+{
+	if (instanceof_function(ce, php_phongo_cursorid_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_CURSORID;
+	}
+
+	if (!instanceof_function(ce, php_phongo_type_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_PROPERTIES;
+	}
+
+	if (instanceof_function(ce, php_phongo_serializable_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_SERIALIZABLE;
+	}
+	if (instanceof_function(ce, php_phongo_document_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_DOCUMENT;
+	}
+	if (instanceof_function(ce, php_phongo_objectid_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_OBJECTID;
+	}
+	if (instanceof_function(ce, php_phongo_utcdatetime_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_UTCDATETIME;
+	}
+	if (instanceof_function(ce, php_phongo_binary_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_BINARY;
+	}
+	if (instanceof_function(ce, php_phongo_decimal128_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_DECIMAL128;
+	}
+	if (instanceof_function(ce, php_phongo_int64_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_INT64;
+	}
+	if (instanceof_function(ce, php_phongo_regex_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_REGEX;
+	}
+	if (instanceof_function(ce, php_phongo_javascript_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_JAVASCRIPT;
+	}
+	if (instanceof_function(ce, php_phongo_timestamp_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_TIMESTAMP;
+	}
+	if (instanceof_function(ce, php_phongo_maxkey_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_MAXKEY;
+	}
+	if (instanceof_function(ce, php_phongo_minkey_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_MINKEY;
+	}
+
+	/* Deprecated types */
+	if (instanceof_function(ce, php_phongo_dbpointer_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_DBPOINTER;
+	}
+	if (instanceof_function(ce, php_phongo_symbol_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_SYMBOL;
+	}
+	if (instanceof_function(ce, php_phongo_undefined_ce TSRMLS_CC)) {
+		return PHONGO_BSON_ENCODE_UNDEFINED;
+	}
+
+	return PHONGO_BSON_ENCODE_UNKNOWN_TYPE;
+} /* }}} */
+
+#if PHP_VERSION_ID >= 70000
+static void php_phongo_bson_encode_class_dtor(zval* zv) /* {{{ */
+{
+	efree(Z_PTR_P(zv));
+} /* }}} */
+#else
+static void php_phongo_bson_encode_class_dtor(void* data) /* {{{ */
+{
+	efree(*(php_phongo_bson_encode_class_t**) data);
+} /* }}} */
+#endif
+
+/* Returns the encode descriptor for the class, computing it on first use. The
+ * descriptors are cached until the end of the request, keyed by the address of
+ * the class entry. */
+static php_phongo_bson_encode_class_t* php_phongo_bson_encode_class(zend_class_entry* ce TSRMLS_DC) /* {{{ */
+{
+	php_phongo_bson_encode_class_t* desc;
+
+	if (!MONGODB_G(encode_class_cache)) {
+		ALLOC_HASHTABLE(MONGODB_G(encode_class_cache));
+		zend_hash_init(MONGODB_G(encode_class_cache), 8, NULL, php_phongo_bson_encode_class_dtor, 0);
+	}
+
+#if PHP_VERSION_ID >= 70000
+	if ((desc = zend_hash_index_find_ptr(MONGODB_G(encode_class_cache), (zend_ulong) ce))) {
+		return desc;
+	}
+#else
+	{
+		php_phongo_bson_encode_class_t** pdesc;
+
+		if (zend_hash_index_find(MONGODB_G(encode_class_cache), (ulong) ce, (void**) &pdesc) == SUCCESS) {
+			return *pdesc;
+		}
+	}
+#endif
+
+	desc                 = emalloc(sizeof(php_phongo_bson_encode_class_t));
+	desc->kind           = php_phongo_bson_encode_kind(ce TSRMLS_CC);
+	desc->is_persistable = instanceof_function(ce, php_phongo_persistable_ce TSRMLS_CC);
+
+#if PHP_VERSION_ID >= 70000
+	zend_hash_index_add_ptr(MONGODB_G(encode_class_cache), (zend_ulong) ce, desc);
+#else
+	zend_hash_index_update(MONGODB_G(encode_class_cache), (ulong) ce, (void*) &desc, sizeof(php_phongo_bson_encode_class_t*), NULL);
+#endif
+
+	return desc;
+} /* }}} */
 
 /* Determines whether the argument should be serialized as a BSON array or
  * document. IS_ARRAY is returned if the argument's keys are a sequence of
@@ -66,6 +248,10 @@ static int php_phongo_is_array_or_document(zval* val TSRMLS_DC) /* {{{ */
 		zend_string* key;
 		zend_ulong   index, idx;
 
+		if (PHONGO_HT_IS_LIST(ht_data)) {
+			return IS_ARRAY;
+		}
+
 		idx = 0;
 		ZEND_HASH_FOREACH_KEY(ht_data, index, key)
 		{
@@ -111,20 +297,64 @@ static int php_phongo_is_array_or_document(zval* val TSRMLS_DC) /* {{{ */
 	return IS_ARRAY;
 } /* }}} */
 
+#if PHP_VERSION_ID >= 70000
+/* Appends the elements of a packed PHP array without holes to a BSON array.
+ * Keys are the element indexes, so they are generated from libbson's key table
+ * instead of being converted from each element's hash key. */
+static void php_phongo_zval_to_bson_list(zval* data, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, bson_t* bson TSRMLS_DC) /* {{{ */
+{
+	zval*       value;
+	uint32_t    index = 0;
+	const char* key;
+	char        key_buf[16];
+	size_t      key_len;
+
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(data), value)
+	{
+		key_len = bson_uint32_to_string(index++, &key, key_buf, sizeof(key_buf));
+
+		/* Numbers are appended directly, since they cannot fail to encode and
+		 * thus do not need their field path recorded */
+		switch (Z_TYPE_P(value)) {
+			case IS_LONG:
+				BSON_APPEND_INT(bson, key, key_len, Z_LVAL_P(value));
+				break;
+
+			case IS_DOUBLE:
+				bson_append_double(bson, key, key_len, Z_DVAL_P(value));
+				break;
+
+			default:
+				php_phongo_bson_append(bson, field_path, flags & ~PHONGO_BSON_ADD_ID, key, key_len, value TSRMLS_CC);
+		}
+	}
+	ZEND_HASH_FOREACH_END();
+} /* }}} */
+#endif
+
 /* Appends the array or object argument to the BSON document. If the object is
  * an instance of MongoDB\BSON\Serializable, the return value of bsonSerialize()
  * will be appended as an embedded document. Other MongoDB\BSON\Type instances
  * will be appended as the appropriate BSON type. Other array or object values
  * will be appended as an embedded document. */
-static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, const char* key, long key_len, zval* object TSRMLS_DC) /* {{{ */
+static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* field_path, php_phongo_bson_flags_t flags, const char* key, long key_len, zval* object, php_phongo_bson_encode_class_t* desc TSRMLS_DC) /* {{{ */
 {
-	if (Z_TYPE_P(object) == IS_OBJECT && instanceof_function(Z_OBJCE_P(object), php_phongo_cursorid_ce TSRMLS_CC)) {
-		bson_append_int64(bson, key, key_len, Z_CURSORID_OBJ_P(object)->id);
+	if (!desc || desc->kind == PHONGO_BSON_ENCODE_PROPERTIES) {
+		bson_t child;
+
+		mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding document");
+		bson_append_document_begin(bson, key, key_len, &child);
+		php_phongo_zval_to_bson_internal(object, field_path, flags, &child, NULL TSRMLS_CC);
+		bson_append_document_end(bson, &child);
 		return;
 	}
 
-	if (Z_TYPE_P(object) == IS_OBJECT && instanceof_function(Z_OBJCE_P(object), php_phongo_type_ce TSRMLS_CC)) {
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_serializable_ce TSRMLS_CC)) {
+	switch (desc->kind) {
+		case PHONGO_BSON_ENCODE_CURSORID:
+			bson_append_int64(bson, key, key_len, Z_CURSORID_OBJ_P(object)->id);
+			return;
+
+		case PHONGO_BSON_ENCODE_SERIALIZABLE: {
 #if PHP_VERSION_ID >= 70000
 			zval obj_data;
 #else
@@ -168,12 +398,12 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			/* Persistable objects must always be serialized as BSON documents;
 			 * otherwise, infer based on bsonSerialize()'s return value. */
 #if PHP_VERSION_ID >= 70000
-			if (instanceof_function(Z_OBJCE_P(object), php_phongo_persistable_ce TSRMLS_CC) || php_phongo_is_array_or_document(&obj_data TSRMLS_CC) == IS_OBJECT) {
+			if (desc->is_persistable || php_phongo_is_array_or_document(&obj_data TSRMLS_CC) == IS_OBJECT) {
 #else
-			if (instanceof_function(Z_OBJCE_P(object), php_phongo_persistable_ce TSRMLS_CC) || php_phongo_is_array_or_document(obj_data TSRMLS_CC) == IS_OBJECT) {
+			if (desc->is_persistable || php_phongo_is_array_or_document(obj_data TSRMLS_CC) == IS_OBJECT) {
 #endif
 				bson_append_document_begin(bson, key, key_len, &child);
-				if (instanceof_function(Z_OBJCE_P(object), php_phongo_persistable_ce TSRMLS_CC)) {
+				if (desc->is_persistable) {
 #if PHP_VERSION_ID >= 70000
 					bson_append_binary(&child, PHONGO_ODM_FIELD_NAME, -1, 0x80, (const uint8_t*) Z_OBJCE_P(object)->name->val, Z_OBJCE_P(object)->name->len);
 #else
@@ -200,7 +430,15 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			return;
 		}
 
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_objectid_ce TSRMLS_CC)) {
+		case PHONGO_BSON_ENCODE_DOCUMENT: {
+			php_phongo_document_t* intern = Z_DOCUMENT_OBJ_P(object);
+
+			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Document");
+			bson_append_document(bson, key, key_len, php_phongo_document_get_bson(intern));
+			return;
+		}
+
+		case PHONGO_BSON_ENCODE_OBJECTID: {
 			bson_oid_t             oid;
 			php_phongo_objectid_t* intern = Z_OBJECTID_OBJ_P(object);
 
@@ -209,42 +447,48 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			bson_append_oid(bson, key, key_len, &oid);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_utcdatetime_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_UTCDATETIME: {
 			php_phongo_utcdatetime_t* intern = Z_UTCDATETIME_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding UTCDateTime");
 			bson_append_date_time(bson, key, key_len, intern->milliseconds);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_binary_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_BINARY: {
 			php_phongo_binary_t* intern = Z_BINARY_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Binary");
 			bson_append_binary(bson, key, key_len, intern->type, (const uint8_t*) intern->data, (uint32_t) intern->data_len);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_decimal128_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_DECIMAL128: {
 			php_phongo_decimal128_t* intern = Z_DECIMAL128_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Decimal128");
 			bson_append_decimal128(bson, key, key_len, &intern->decimal);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_int64_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_INT64: {
 			php_phongo_int64_t* intern = Z_INT64_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Int64");
 			bson_append_int64(bson, key, key_len, intern->integer);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_regex_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_REGEX: {
 			php_phongo_regex_t* intern = Z_REGEX_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Regex");
 			bson_append_regex(bson, key, key_len, intern->pattern, intern->flags);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_javascript_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_JAVASCRIPT: {
 			php_phongo_javascript_t* intern = Z_JAVASCRIPT_OBJ_P(object);
 
 			if (intern->scope) {
@@ -256,26 +500,29 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			}
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_timestamp_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_TIMESTAMP: {
 			php_phongo_timestamp_t* intern = Z_TIMESTAMP_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Timestamp");
 			bson_append_timestamp(bson, key, key_len, intern->timestamp, intern->increment);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_maxkey_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_MAXKEY: {
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding MaxKey");
 			bson_append_maxkey(bson, key, key_len);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_minkey_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_MINKEY: {
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding MinKey");
 			bson_append_minkey(bson, key, key_len);
 			return;
 		}
 
 		/* Deprecated types */
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_dbpointer_ce TSRMLS_CC)) {
+		case PHONGO_BSON_ENCODE_DBPOINTER: {
 			bson_oid_t              oid;
 			php_phongo_dbpointer_t* intern = Z_DBPOINTER_OBJ_P(object);
 
@@ -284,28 +531,24 @@ static void php_phongo_bson_append_object(bson_t* bson, php_phongo_field_path* f
 			bson_append_dbpointer(bson, key, key_len, intern->ref, &oid);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_symbol_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_SYMBOL: {
 			php_phongo_symbol_t* intern = Z_SYMBOL_OBJ_P(object);
 
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Symbol");
 			bson_append_symbol(bson, key, key_len, intern->symbol, intern->symbol_len);
 			return;
 		}
-		if (instanceof_function(Z_OBJCE_P(object), php_phongo_undefined_ce TSRMLS_CC)) {
+
+		case PHONGO_BSON_ENCODE_UNDEFINED: {
 			mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding Undefined");
 			bson_append_undefined(bson, key, key_len);
 			return;
 		}
 
-		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Unexpected %s instance: %s", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(object)->name));
-		return;
-	} else {
-		bson_t child;
-
-		mongoc_log(MONGOC_LOG_LEVEL_TRACE, MONGOC_LOG_DOMAIN, "encoding document");
-		bson_append_document_begin(bson, key, key_len, &child);
-		php_phongo_zval_to_bson_internal(object, field_path, flags, &child, NULL TSRMLS_CC);
-		bson_append_document_end(bson, &child);
+		default:
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Unexpected %s instance: %s", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(object)->name));
+			return;
 	}
 } /* }}} */
 
@@ -346,7 +589,7 @@ try_again:
 			break;
 
 		case IS_STRING:
-			if (bson_utf8_validate(Z_STRVAL_P(entry), Z_STRLEN_P(entry), true)) {
+			if (php_phongo_zval_is_utf8(entry)) {
 				bson_append_utf8(bson, key, key_len, Z_STRVAL_P(entry), Z_STRLEN_P(entry));
 			} else {
 				char* path_string = php_phongo_field_path_as_string(field_path);
@@ -370,7 +613,15 @@ try_again:
 				bson_append_array_begin(bson, key, key_len, &child);
 				php_phongo_field_path_write_type_at_current_level(field_path, PHONGO_FIELD_PATH_ITEM_ARRAY);
 				field_path->size++;
+#if PHP_VERSION_ID >= 70000
+				if (PHONGO_HT_IS_LIST(tmp_ht)) {
+					php_phongo_zval_to_bson_list(entry, field_path, flags, &child TSRMLS_CC);
+				} else {
+					php_phongo_zval_to_bson_internal(entry, field_path, flags, &child, NULL TSRMLS_CC);
+				}
+#else
 				php_phongo_zval_to_bson_internal(entry, field_path, flags, &child, NULL TSRMLS_CC);
+#endif
 				field_path->size--;
 				bson_append_array_end(bson, &child);
 
@@ -380,21 +631,37 @@ try_again:
 			PHONGO_BREAK_INTENTIONALLY_MISSING
 
 		case IS_OBJECT: {
-			HashTable* tmp_ht = HASH_OF(entry);
+			php_phongo_bson_encode_class_t* desc   = NULL;
+			HashTable*                      tmp_ht = NULL;
+			bool                            detect_recursion;
 
-			if (!php_phongo_zend_hash_apply_protection_begin(tmp_ht)) {
-				char* path_string = php_phongo_field_path_as_string(field_path);
-				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected recursion for field path \"%s\"", path_string);
-				efree(path_string);
-				break;
+			if (Z_TYPE_P(entry) == IS_OBJECT) {
+				desc = php_phongo_bson_encode_class(Z_OBJCE_P(entry) TSRMLS_CC);
+			}
+
+			/* BSON types cannot be recursive, so there is no need to fetch
+			 * their properties for recursion detection */
+			detect_recursion = !desc || !PHONGO_BSON_ENCODE_IS_LEAF(desc);
+
+			if (detect_recursion) {
+				tmp_ht = HASH_OF(entry);
+
+				if (!php_phongo_zend_hash_apply_protection_begin(tmp_ht)) {
+					char* path_string = php_phongo_field_path_as_string(field_path);
+					phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected recursion for field path \"%s\"", path_string);
+					efree(path_string);
+					break;
+				}
 			}
 
 			php_phongo_field_path_write_type_at_current_level(field_path, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
 			field_path->size++;
-			php_phongo_bson_append_object(bson, field_path, flags, key, key_len, entry TSRMLS_CC);
+			php_phongo_bson_append_object(bson, field_path, flags, key, key_len, entry, desc TSRMLS_CC);
 			field_path->size--;
 
-			php_phongo_zend_hash_apply_protection_end(tmp_ht);
+			if (detect_recursion) {
+				php_phongo_zend_hash_apply_protection_end(tmp_ht);
+			}
 			break;
 		}
 
@@ -438,8 +705,10 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 	ZVAL_UNDEF(&obj_data);
 
 	switch (Z_TYPE_P(data)) {
-		case IS_OBJECT:
-			if (instanceof_function(Z_OBJCE_P(data), php_phongo_serializable_ce TSRMLS_CC)) {
+		case IS_OBJECT: {
+			php_phongo_bson_encode_class_t* desc = php_phongo_bson_encode_class(Z_OBJCE_P(data) TSRMLS_CC);
+
+			if (desc->kind == PHONGO_BSON_ENCODE_SERIALIZABLE) {
 #if PHP_VERSION_ID >= 70000
 				zend_call_method_with_0_params(data, NULL, NULL, BSON_SERIALIZE_FUNC_NAME, &obj_data);
 #else
@@ -478,7 +747,7 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 				ht_data = HASH_OF(obj_data);
 #endif
 
-				if (instanceof_function(Z_OBJCE_P(data), php_phongo_persistable_ce TSRMLS_CC)) {
+				if (desc->is_persistable) {
 #if PHP_VERSION_ID >= 70000
 					bson_append_binary(bson, PHONGO_ODM_FIELD_NAME, -1, 0x80, (const uint8_t*) Z_OBJCE_P(data)->name->val, Z_OBJCE_P(data)->name->len);
 #else
@@ -492,7 +761,21 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 				break;
 			}
 
-			if (instanceof_function(Z_OBJCE_P(data), php_phongo_type_ce TSRMLS_CC)) {
+			/* A Document's raw BSON may be copied as-is, with only the "_id"
+			 * handling below left to do. */
+			if (desc->kind == PHONGO_BSON_ENCODE_DOCUMENT) {
+				const bson_t* document = php_phongo_document_get_bson(Z_DOCUMENT_OBJ_P(data));
+
+				if ((flags & PHONGO_BSON_ADD_ID) && bson_has_field(document, "_id")) {
+					flags &= ~PHONGO_BSON_ADD_ID;
+				}
+
+				bson_concat(bson, document);
+
+				goto append_id;
+			}
+
+			if (desc->kind != PHONGO_BSON_ENCODE_PROPERTIES && desc->kind != PHONGO_BSON_ENCODE_CURSORID) {
 				phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "%s instance %s cannot be serialized as a root element", ZSTR_VAL(php_phongo_type_ce->name), ZSTR_VAL(Z_OBJCE_P(data)->name));
 				return;
 			}
@@ -500,6 +783,7 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 			ht_data                 = Z_OBJ_HT_P(data)->get_properties(data TSRMLS_CC);
 			ht_data_from_properties = true;
 			break;
+		}
 
 		case IS_ARRAY:
 			ht_data = HASH_OF(data);
@@ -612,6 +896,7 @@ static void php_phongo_zval_to_bson_internal(zval* data, php_phongo_field_path*
 	}
 #endif
 
+append_id:
 	if (flags & PHONGO_BSON_ADD_ID) {
 		bson_oid_t oid;
 
@@ -19,6 +19,9 @@
 #include <php.h>
 #include <Zend/zend_hash.h>
 #include <Zend/zend_interfaces.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -29,6 +32,8 @@
 #include "phongo_compat.h"
 #include "php_array_api.h"
 
+ZEND_EXTERN_MODULE_GLOBALS(mongodb)
+
 #define DEBUG 0
 
 #undef MONGOC_LOG_DOMAIN
@@ -45,6 +50,48 @@
 
 #define PHONGO_FIELD_PATH_EXPANSION 8
 
+/* Maximum number of distinct keys retained by a key cache. Once the cache is
+ * full, keys that are not yet cached are allocated for each document. */
+#define PHONGO_BSON_KEY_CACHE_SIZE 1024
+
+#if PHP_VERSION_ID >= 70000
+#define PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, value) php_phongo_bson_add_assoc_zval((php_phongo_bson_state*) (state), (retval), (key), (value))
+#else
+#define PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, value) ADD_ASSOC_ZVAL((retval), (key), (value))
+#endif
+
+#if PHP_VERSION_ID >= 70000
+#define PHONGO_BSON_ZVAL_STRINGL(zv, s, slen) ZVAL_STRINGL((zv), (s), (slen))
+#else
+#define PHONGO_BSON_ZVAL_STRINGL(zv, s, slen) ZVAL_STRINGL((zv), (s), (slen), 1)
+#endif
+
+/* Classes used while decoding are cached for the duration of the request,
+ * keyed by class name. Entries are only created for instantiatable classes and
+ * record whether the class implements Persistable, as well as its
+ * bsonUnserialize() implementation, so that neither has to be looked up for
+ * each document. */
+typedef struct {
+	zend_class_entry* ce;
+	zend_function*    unserialize;
+	bool              is_persistable;
+	HashTable*        hydrate_plan;
+} php_phongo_bson_class_t;
+
+/* Decode plans for Hydratable classes map BSON field names to the property
+ * each field is written to. On PHP 7, declared (and untyped) properties are
+ * written directly to their slot in the object's property table. */
+typedef struct {
+#if PHP_VERSION_ID >= 70000
+	zend_string* name;
+	uint32_t     offset;
+	bool         has_slot;
+#else
+	char*  name;
+	size_t name_len;
+#endif
+} php_phongo_bson_hydrate_property_t;
+
 /* Forward declarations */
 static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data);
 static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data);
@@ -191,7 +238,112 @@ void php_phongo_bson_state_copy_ctor(php_phongo_bson_state* dst, php_phongo_bson
 		src->field_path->ref_count++;
 	}
 	dst->field_path = src->field_path;
+	dst->key_cache  = src->key_cache;
+}
+
+/* Initializes a key cache for the state, which allows documents decoded with
+ * the same state (e.g. by a cursor) to share the strings used for field names.
+ * The cache is only used on PHP 7, where array keys are zend_strings. */
+void php_phongo_bson_state_key_cache_ctor(php_phongo_bson_state* state)
+{
+#if PHP_VERSION_ID >= 70000
+	if (state->key_cache) {
+		return;
+	}
+
+	ALLOC_HASHTABLE(state->key_cache);
+	zend_hash_init(state->key_cache, 32, NULL, ZVAL_PTR_DTOR, 0);
+#endif
+}
+
+void php_phongo_bson_state_key_cache_dtor(php_phongo_bson_state* state)
+{
+	if (state->key_cache) {
+		zend_hash_destroy(state->key_cache);
+		FREE_HASHTABLE(state->key_cache);
+		state->key_cache = NULL;
+	}
+}
+
+#if PHP_VERSION_ID >= 70000
+/* Writes a decoded value to the property that the BSON field is mapped to,
+ * taking over the reference to the value. Values of unmapped fields are
+ * discarded. */
+static void php_phongo_bson_hydrate_property(php_phongo_bson_state* state, zval* object, const char* key, zval* value)
+{
+	php_phongo_bson_hydrate_property_t* property = zend_hash_str_find_ptr(state->hydrate_plan, key, strlen(key));
+	zval*                               slot;
+	zval                                garbage;
+
+	if (!property) {
+		zval_ptr_dtor(value);
+		return;
+	}
+
+	if (!property->has_slot) {
+		zend_update_property(state->hydrate_ce, object, ZSTR_VAL(property->name), ZSTR_LEN(property->name), value);
+		zval_ptr_dtor(value);
+		return;
+	}
+
+	slot = OBJ_PROP(Z_OBJ_P(object), property->offset);
+
+	ZVAL_COPY_VALUE(&garbage, slot);
+	ZVAL_COPY_VALUE(slot, value);
+	zval_ptr_dtor(&garbage);
+}
+
+/* Adds a value to an array under a string key. If the state has a key cache,
+ * the key's zend_string (with its precomputed hash) is shared with previously
+ * decoded documents instead of being allocated again. When hydrating an
+ * object, the value is written to the mapped property instead. */
+static void php_phongo_bson_add_assoc_zval(php_phongo_bson_state* state, zval* retval, const char* key, zval* value)
+{
+	size_t       key_len = strlen(key);
+	zval*        cached;
+	zend_string* zs_key;
+
+	if (state->hydrate_plan) {
+		php_phongo_bson_hydrate_property(state, retval, key, value);
+		return;
+	}
+
+	/* When recycling the previous document, php_phongo_bson_to_zval_recycle()
+	 * has checked that fields occur in the same order as its buckets, so each
+	 * value replaces the one in the corresponding bucket */
+	if (state->recycle_ht) {
+		Bucket* bucket = state->recycle_ht->arData + state->recycle_pos++;
+
+		zval_ptr_dtor(&bucket->val);
+		ZVAL_COPY_VALUE(&bucket->val, value);
+		return;
+	}
+
+	if (!state->key_cache) {
+		zend_symtable_str_update(Z_ARRVAL_P(retval), key, key_len, value);
+		return;
+	}
+
+	if ((cached = zend_hash_str_find(state->key_cache, key, key_len))) {
+		zend_symtable_update(Z_ARRVAL_P(retval), Z_STR_P(cached), value);
+		return;
+	}
+
+	zs_key = zend_string_init(key, key_len, 0);
+	zend_string_hash_val(zs_key);
+	zend_symtable_update(Z_ARRVAL_P(retval), zs_key, value);
+
+	if (zend_hash_num_elements(state->key_cache) < PHONGO_BSON_KEY_CACHE_SIZE) {
+		zval zkey;
+
+		/* The cache takes over our reference to the key */
+		ZVAL_STR(&zkey, zs_key);
+		zend_hash_add_new(state->key_cache, zs_key, &zkey);
+	} else {
+		zend_string_release(zs_key);
+	}
 }
+#endif
 
 void php_phongo_bson_state_dtor(php_phongo_bson_state* state)
 {
@@ -205,247 +357,860 @@ void php_phongo_bson_state_dtor(php_phongo_bson_state* state)
 	}
 } /* }}} */
 
-static void php_phongo_bson_visit_corrupt(const bson_iter_t* iter ARG_UNUSED, void* data ARG_UNUSED) /* {{{ */
+/* Returns whether a field should not be decoded at all, because it is not
+ * mapped to a property of the object being hydrated. */
+static bool php_phongo_bson_state_skips_field(php_phongo_bson_state* state, const char* key) /* {{{ */
 {
-	mongoc_log(MONGOC_LOG_LEVEL_WARNING, MONGOC_LOG_DOMAIN, "Corrupt BSON data detected!");
+#if PHP_VERSION_ID >= 70000
+	return state->hydrate_plan && !zend_hash_str_exists(state->hydrate_plan, key, strlen(key));
+#else
+	return false;
+#endif
 } /* }}} */
 
-static void php_phongo_bson_visit_unsupported_type(const bson_iter_t* iter ARG_UNUSED, const char* key, uint32_t v_type_code, void* data ARG_UNUSED) /* {{{ */
+#if PHP_VERSION_ID >= 70000
+static void php_phongo_bson_hydrate_property_dtor(zval* zv) /* {{{ */
 {
-	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
-	char*                  path_string;
-	TSRMLS_FETCH();
+	php_phongo_bson_hydrate_property_t* property = Z_PTR_P(zv);
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-	path_string = php_phongo_field_path_as_string(state->field_path);
-
-	phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected unknown BSON type 0x%02hhx for field path \"%s\". Are you using the latest driver?", (unsigned char) v_type_code, path_string);
+	zend_string_release(property->name);
+	efree(property);
+} /* }}} */
+#else
+static void php_phongo_bson_hydrate_property_dtor(void* data) /* {{{ */
+{
+	php_phongo_bson_hydrate_property_t* property = *(php_phongo_bson_hydrate_property_t**) data;
 
-	efree(path_string);
+	efree(property->name);
+	efree(property);
 } /* }}} */
+#endif
 
-static bool php_phongo_bson_visit_double(const bson_iter_t* iter ARG_UNUSED, const char* key, double v_double, void* data) /* {{{ */
+static void php_phongo_bson_class_free(php_phongo_bson_class_t* entry) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-
-	if (state->is_visiting_array) {
-		add_next_index_double(retval, v_double);
-	} else {
-		add_assoc_double(retval, key, v_double);
+	if (entry->hydrate_plan) {
+		zend_hash_destroy(entry->hydrate_plan);
+		FREE_HASHTABLE(entry->hydrate_plan);
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	efree(entry);
 } /* }}} */
 
-static bool php_phongo_bson_visit_utf8(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_utf8_len, const char* v_utf8, void* data) /* {{{ */
+#if PHP_VERSION_ID >= 70000
+static void php_phongo_bson_class_dtor(zval* zv) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_class_free(Z_PTR_P(zv));
+} /* }}} */
+#else
+static void php_phongo_bson_class_dtor(void* data) /* {{{ */
+{
+	php_phongo_bson_class_free(*(php_phongo_bson_class_t**) data);
+} /* }}} */
+#endif
 
-	if (state->is_visiting_array) {
-		ADD_NEXT_INDEX_STRINGL(retval, v_utf8, v_utf8_len);
-	} else {
-		ADD_ASSOC_STRING_EX(retval, key, strlen(key), v_utf8, v_utf8_len);
+static HashTable* php_phongo_bson_class_cache(TSRMLS_D) /* {{{ */
+{
+	if (!MONGODB_G(class_cache)) {
+		ALLOC_HASHTABLE(MONGODB_G(class_cache));
+		zend_hash_init(MONGODB_G(class_cache), 8, NULL, php_phongo_bson_class_dtor, 0);
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return MONGODB_G(class_cache);
 } /* }}} */
 
-static bool php_phongo_bson_visit_binary(const bson_iter_t* iter ARG_UNUSED, const char* key, bson_subtype_t v_subtype, size_t v_binary_len, const uint8_t* v_binary, void* data) /* {{{ */
+/* Adds an entry for the class to the cache. On PHP 5.x, classname must be NULL
+ * terminated. */
+static php_phongo_bson_class_t* php_phongo_bson_class_cache_add(const char* classname, size_t classname_len, zend_class_entry* ce TSRMLS_DC) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-	TSRMLS_FETCH();
+	php_phongo_bson_class_t* entry = emalloc(sizeof(php_phongo_bson_class_t));
+
+	entry->ce             = ce;
+	entry->is_persistable = instanceof_function(ce, php_phongo_persistable_ce TSRMLS_CC);
+	entry->hydrate_plan   = NULL;
 
-	if (v_subtype == 0x80 && strcmp(key, PHONGO_ODM_FIELD_NAME) == 0) {
 #if PHP_VERSION_ID >= 70000
-		zend_string*      zs_classname = zend_string_init((const char*) v_binary, v_binary_len, 0);
-		zend_class_entry* found_ce     = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
-		zend_string_release(zs_classname);
+	entry->unserialize = zend_hash_str_find_ptr(&ce->function_table, ZEND_STRL("bsonunserialize"));
+	zend_hash_str_update_ptr(php_phongo_bson_class_cache(TSRMLS_C), classname, classname_len, entry);
 #else
-		zend_class_entry* found_ce = zend_fetch_class((const char*) v_binary, v_binary_len, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
+	if (zend_hash_find(&ce->function_table, "bsonunserialize", sizeof("bsonunserialize"), (void**) &entry->unserialize) == FAILURE) {
+		entry->unserialize = NULL;
+	}
+	zend_hash_update(php_phongo_bson_class_cache(TSRMLS_C), classname, classname_len + 1, (void*) &entry, sizeof(php_phongo_bson_class_t*), NULL);
 #endif
 
-		if (found_ce && PHONGO_IS_CLASS_INSTANTIATABLE(found_ce) && instanceof_function(found_ce, php_phongo_persistable_ce TSRMLS_CC)) {
-			((php_phongo_bson_state*) data)->odm = found_ce;
-		}
+	return entry;
+} /* }}} */
+
+/* Returns the cached entry for the given class name, fetching (and possibly
+ * autoloading) the class on first use. NULL is returned if the class does not
+ * exist or is not instantiatable; no exception is thrown. */
+static php_phongo_bson_class_t* php_phongo_bson_class_cache_find(const char* classname, size_t classname_len TSRMLS_DC) /* {{{ */
+{
+	php_phongo_bson_class_t* entry    = NULL;
+	zend_class_entry*        found_ce = NULL;
+
+#if PHP_VERSION_ID >= 70000
+	if ((entry = zend_hash_str_find_ptr(php_phongo_bson_class_cache(TSRMLS_C), classname, classname_len))) {
+		return entry;
 	}
 
 	{
-#if PHP_VERSION_ID >= 70000
-		zval zchild;
+		zend_string* zs_classname = zend_string_init(classname, classname_len, 0);
+		found_ce                  = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
+		zend_string_release(zs_classname);
+	}
 
-		php_phongo_new_binary_from_binary_and_type(&zchild, (const char*) v_binary, v_binary_len, v_subtype TSRMLS_CC);
+	if (found_ce && PHONGO_IS_CLASS_INSTANTIATABLE(found_ce)) {
+		entry = php_phongo_bson_class_cache_add(classname, classname_len, found_ce TSRMLS_CC);
+	}
+#else
+	{
+		/* The class name may come from a BSON binary, which is not NULL
+		 * terminated, but HashTable keys must be */
+		char*                     name = estrndup(classname, classname_len);
+		php_phongo_bson_class_t** pentry;
 
-		if (state->is_visiting_array) {
-			add_next_index_zval(retval, &zchild);
+		if (zend_hash_find(php_phongo_bson_class_cache(TSRMLS_C), name, classname_len + 1, (void**) &pentry) == SUCCESS) {
+			entry = *pentry;
 		} else {
-			ADD_ASSOC_ZVAL(retval, key, &zchild);
-		}
-#else  /* PHP_VERSION_ID >= 70000 */
-		zval*             zchild   = NULL;
-
-		MAKE_STD_ZVAL(zchild);
-		php_phongo_new_binary_from_binary_and_type(zchild, (const char*) v_binary, v_binary_len, v_subtype TSRMLS_CC);
+			found_ce = zend_fetch_class(name, classname_len, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
 
-		if (state->is_visiting_array) {
-			add_next_index_zval(retval, zchild);
-		} else {
-			ADD_ASSOC_ZVAL(retval, key, zchild);
+			if (found_ce && PHONGO_IS_CLASS_INSTANTIATABLE(found_ce)) {
+				entry = php_phongo_bson_class_cache_add(name, classname_len, found_ce TSRMLS_CC);
+			}
 		}
-#endif /* PHP_VERSION_ID >= 70000 */
-	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+		efree(name);
+	}
+#endif
 
-	return false;
+	return entry;
 } /* }}} */
 
-static bool php_phongo_bson_visit_undefined(const bson_iter_t* iter, const char* key, void* data) /* {{{ */
+/* Returns the cached entry for a class that has already been resolved. */
+static php_phongo_bson_class_t* php_phongo_bson_class_cache_find_ce(zend_class_entry* ce TSRMLS_DC) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-#if PHP_VERSION_ID >= 70000 /* PHP_VERSION_ID >= 70000 */
-	zval zchild;
-
-	object_init_ex(&zchild, php_phongo_undefined_ce);
+#if PHP_VERSION_ID >= 70000
+	php_phongo_bson_class_t* entry = zend_hash_find_ptr(php_phongo_bson_class_cache(TSRMLS_C), ce->name);
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (entry && entry->ce == ce) {
+		return entry;
 	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
-	TSRMLS_FETCH();
 
-	MAKE_STD_ZVAL(zchild);
-	object_init_ex(zchild, php_phongo_undefined_ce);
+	return php_phongo_bson_class_cache_add(ZSTR_VAL(ce->name), ZSTR_LEN(ce->name), ce TSRMLS_CC);
+#else
+	php_phongo_bson_class_t** pentry;
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+	if (zend_hash_find(php_phongo_bson_class_cache(TSRMLS_C), ce->name, ce->name_length + 1, (void**) &pentry) == SUCCESS && (*pentry)->ce == ce) {
+		return *pentry;
 	}
-#endif /* PHP_VERSION_ID >= 70000 */
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+	return php_phongo_bson_class_cache_add(ce->name, ce->name_length, ce TSRMLS_CC);
+#endif
 } /* }}} */
 
-static bool php_phongo_bson_visit_oid(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_oid_t* v_oid, void* data) /* {{{ */
+/* Calls bsonUnserialize() on an object of the given class, using the function
+ * handle resolved when the class was cached. */
+static void php_phongo_bson_unserialize(zval* obj, zend_class_entry* ce, zval* data TSRMLS_DC) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-#if PHP_VERSION_ID >= 70000
-	zval zchild;
-
-	php_phongo_objectid_new_from_oid(&zchild, v_oid TSRMLS_CC);
+	zend_function* unserialize = php_phongo_bson_class_cache_find_ce(ce TSRMLS_CC)->unserialize;
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
+#if PHP_VERSION_ID >= 70000
+	if (unserialize) {
+		zend_call_method(obj, ce, &unserialize, ZEND_STRL(BSON_UNSERIALIZE_FUNC_NAME), NULL, 1, data, NULL);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		zend_call_method_with_1_params(obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, data);
 	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
-	TSRMLS_FETCH();
-
-	MAKE_STD_ZVAL(zchild);
-	php_phongo_objectid_new_from_oid(zchild, v_oid TSRMLS_CC);
-
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, zchild);
+#else
+	if (unserialize) {
+		zend_call_method(&obj, ce, &unserialize, ZEND_STRL(BSON_UNSERIALIZE_FUNC_NAME), NULL, 1, data, NULL TSRMLS_CC);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, data);
 	}
-#endif /* PHP_VERSION_ID >= 70000 */
-
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
-
-	return false;
+#endif
 } /* }}} */
 
-static bool php_phongo_bson_visit_bool(const bson_iter_t* iter ARG_UNUSED, const char* key, bool v_bool, void* data) /* {{{ */
+/* Adds a BSON field to a decode plan. On PHP 5.x, field must be NULL
+ * terminated. */
+static void php_phongo_bson_hydrate_plan_add(HashTable* plan, zend_class_entry* ce, const char* field, size_t field_len, const char* name, size_t name_len) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	php_phongo_bson_hydrate_property_t* property = emalloc(sizeof(php_phongo_bson_hydrate_property_t));
 
-	if (state->is_visiting_array) {
-		add_next_index_bool(retval, v_bool);
-	} else {
-		add_assoc_bool(retval, key, v_bool);
+#if PHP_VERSION_ID >= 70000
+	zend_property_info* info;
+
+	property->name     = zend_string_init(name, name_len, 0);
+	property->offset   = 0;
+	property->has_slot = false;
+
+	/* Only properties declared by the class itself have a slot we may write
+	 * to. Typed properties are assigned through the object handlers, so that
+	 * their type is enforced. */
+	info = zend_hash_find_ptr(&ce->properties_info, property->name);
+
+	if (info && !(info->flags & ZEND_ACC_STATIC)) {
+		property->offset   = info->offset;
+		property->has_slot = true;
+#ifdef ZEND_ACC_SHADOW
+		if (info->flags & ZEND_ACC_SHADOW) {
+			property->has_slot = false;
+		}
+#endif
+#if PHP_VERSION_ID >= 70400
+		if (ZEND_TYPE_IS_SET(info->type)) {
+			property->has_slot = false;
+		}
+#endif
 	}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	zend_hash_str_update_ptr(plan, field, field_len, property);
+#else
+	property->name     = estrndup(name, name_len);
+	property->name_len = name_len;
 
-	return false;
+	zend_hash_update(plan, field, field_len + 1, (void*) &property, sizeof(php_phongo_bson_hydrate_property_t*), NULL);
+#endif
 } /* }}} */
 
-static bool php_phongo_bson_visit_date_time(const bson_iter_t* iter ARG_UNUSED, const char* key, int64_t msec_since_epoch, void* data) /* {{{ */
+/* Adds all non-static properties declared by the class to a decode plan, using
+ * the property names as BSON field names. */
+static void php_phongo_bson_hydrate_plan_infer(HashTable* plan, zend_class_entry* ce) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
 #if PHP_VERSION_ID >= 70000
-	zval zchild;
+	zend_string*        name;
+	zend_property_info* info;
 
-	php_phongo_new_utcdatetime_from_epoch(&zchild, msec_since_epoch TSRMLS_CC);
+	ZEND_HASH_FOREACH_STR_KEY_PTR(&ce->properties_info, name, info)
+	{
+		if (!name || (info->flags & ZEND_ACC_STATIC)) {
+			continue;
+		}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		php_phongo_bson_hydrate_plan_add(plan, ce, ZSTR_VAL(name), ZSTR_LEN(name), ZSTR_VAL(name), ZSTR_LEN(name));
 	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
-	TSRMLS_FETCH();
+	ZEND_HASH_FOREACH_END();
+#else
+	HashPosition pos;
 
-	MAKE_STD_ZVAL(zchild);
-	php_phongo_new_utcdatetime_from_epoch(zchild, msec_since_epoch TSRMLS_CC);
+	zend_hash_internal_pointer_reset_ex(&ce->properties_info, &pos);
+	for (;; zend_hash_move_forward_ex(&ce->properties_info, &pos)) {
+		char*               name     = NULL;
+		uint                name_len = 0;
+		ulong               num_key  = 0;
+		zend_property_info* info;
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
-	}
-#endif /* PHP_VERSION_ID >= 70000 */
+		if (zend_hash_get_current_key_ex(&ce->properties_info, &name, &name_len, &num_key, 0, &pos) != HASH_KEY_IS_STRING) {
+			break;
+		}
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+		if (zend_hash_get_current_data_ex(&ce->properties_info, (void**) &info, &pos) == FAILURE) {
+			break;
+		}
 
-	return false;
+		if (info->flags & ZEND_ACC_STATIC) {
+			continue;
+		}
+
+		php_phongo_bson_hydrate_plan_add(plan, ce, name, name_len - 1, name, name_len - 1);
+	}
+#endif
 } /* }}} */
 
-static bool php_phongo_bson_visit_decimal128(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_decimal128_t* decimal, void* data) /* {{{ */
+/* Adds the BSON fields returned by the class' bsonFieldMap() method to a
+ * decode plan. Returns true on success; otherwise, false is returned and an
+ * exception is thrown. */
+static bool php_phongo_bson_hydrate_plan_map(HashTable* plan, zend_class_entry* ce, zval* field_map TSRMLS_DC) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
 #if PHP_VERSION_ID >= 70000
-	zval zchild;
+	zend_string* field   = NULL;
+	zend_ulong   num_key = 0;
+	zval*        name;
 
-	php_phongo_new_decimal128(&zchild, decimal TSRMLS_CC);
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(field_map), num_key, field, name)
+	{
+		if (Z_TYPE_P(name) != IS_STRING) {
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Expected %s::%s() to return an array mapping field names to property names", ZSTR_VAL(ce->name), BSON_FIELD_MAP_FUNC_NAME);
+			return false;
+		}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
-	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
+		/* Numeric field names (e.g. array indexes) have integer keys */
+		if (!field) {
+			field = zend_long_to_str(num_key);
+		} else {
+			zend_string_addref(field);
+		}
+
+		php_phongo_bson_hydrate_plan_add(plan, ce, ZSTR_VAL(field), ZSTR_LEN(field), Z_STRVAL_P(name), Z_STRLEN_P(name));
+
+		zend_string_release(field);
+	}
+	ZEND_HASH_FOREACH_END();
+#else
+	HashPosition pos;
+	HashTable*   ht_data = Z_ARRVAL_P(field_map);
+
+	zend_hash_internal_pointer_reset_ex(ht_data, &pos);
+	for (;; zend_hash_move_forward_ex(ht_data, &pos)) {
+		char*  field     = NULL;
+		uint   field_len = 0;
+		ulong  num_key   = 0;
+		zval** name;
+		int    hash_type;
+
+		hash_type = zend_hash_get_current_key_ex(ht_data, &field, &field_len, &num_key, 0, &pos);
+
+		if (hash_type == HASH_KEY_NON_EXISTENT) {
+			break;
+		}
+
+		if (zend_hash_get_current_data_ex(ht_data, (void**) &name, &pos) == FAILURE) {
+			break;
+		}
+
+		if (Z_TYPE_PP(name) != IS_STRING) {
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Expected %s::%s() to return an array mapping field names to property names", ZSTR_VAL(ce->name), BSON_FIELD_MAP_FUNC_NAME);
+			return false;
+		}
+
+		/* Numeric field names (e.g. array indexes) have integer keys */
+		if (hash_type == HASH_KEY_IS_LONG) {
+			field_len = spprintf(&field, 0, "%ld", num_key) + 1;
+		}
+
+		php_phongo_bson_hydrate_plan_add(plan, ce, field, field_len - 1, Z_STRVAL_PP(name), Z_STRLEN_PP(name));
+
+		if (hash_type == HASH_KEY_IS_LONG) {
+			efree(field);
+		}
+	}
+#endif
+
+	return true;
+} /* }}} */
+
+/* Returns the decode plan for a Hydratable class, compiling it on first use
+ * from the class' bsonFieldMap() method. If that method returns null, the plan
+ * is inferred from the properties declared by the class. Returns NULL and
+ * throws an exception if the plan could not be compiled. */
+static HashTable* php_phongo_bson_hydrate_plan(zend_class_entry* ce TSRMLS_DC) /* {{{ */
+{
+	php_phongo_bson_class_t* entry = php_phongo_bson_class_cache_find_ce(ce TSRMLS_CC);
+	HashTable*               plan;
+	bool                     success = false;
+	ZVAL_RETVAL_TYPE         field_map;
+
+	if (entry->hydrate_plan) {
+		return entry->hydrate_plan;
+	}
+
+	ALLOC_HASHTABLE(plan);
+	zend_hash_init(plan, 8, NULL, php_phongo_bson_hydrate_property_dtor, 0);
+
+#if PHP_VERSION_ID >= 70000
+	ZVAL_UNDEF(&field_map);
+	zend_call_method(NULL, ce, NULL, ZEND_STRL("bsonfieldmap"), &field_map, 0, NULL, NULL);
+#else
+	field_map = NULL;
+	zend_call_method(NULL, ce, NULL, ZEND_STRL("bsonfieldmap"), &field_map, 0, NULL, NULL TSRMLS_CC);
+#endif
+
+	if (Z_ISUNDEF(field_map) || EG(exception)) {
+		/* zend_call_method() failed or bsonFieldMap() threw an exception */
+		goto cleanup;
+	}
+
+#if PHP_VERSION_ID >= 70000
+	if (Z_TYPE(field_map) == IS_NULL) {
+		php_phongo_bson_hydrate_plan_infer(plan, ce);
+		success = true;
+	} else if (Z_TYPE(field_map) == IS_ARRAY) {
+		success = php_phongo_bson_hydrate_plan_map(plan, ce, &field_map TSRMLS_CC);
+	} else {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Expected %s::%s() to return an array or null, %s given", ZSTR_VAL(ce->name), BSON_FIELD_MAP_FUNC_NAME, PHONGO_ZVAL_CLASS_OR_TYPE_NAME(field_map));
+	}
+#else
+	if (Z_TYPE_P(field_map) == IS_NULL) {
+		php_phongo_bson_hydrate_plan_infer(plan, ce);
+		success = true;
+	} else if (Z_TYPE_P(field_map) == IS_ARRAY) {
+		success = php_phongo_bson_hydrate_plan_map(plan, ce, field_map TSRMLS_CC);
+	} else {
+		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Expected %s::%s() to return an array or null, %s given", ZSTR_VAL(ce->name), BSON_FIELD_MAP_FUNC_NAME, PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(field_map));
+	}
+#endif
+
+cleanup:
+	if (!Z_ISUNDEF(field_map)) {
+		zval_ptr_dtor(&field_map);
+	}
+
+	if (!success) {
+		zend_hash_destroy(plan);
+		FREE_HASHTABLE(plan);
+
+		return NULL;
+	}
+
+	entry->hydrate_plan = plan;
+
+	return plan;
+} /* }}} */
+
+#if PHP_VERSION_ID < 70000
+/* Assigns the values of a decoded document to the properties of a Hydratable
+ * object according to its decode plan. On PHP 7, visitors write directly to
+ * the object's properties instead. */
+static void php_phongo_bson_hydrate_object(zval* object, zend_class_entry* ce, HashTable* plan, zval* data TSRMLS_DC) /* {{{ */
+{
+	HashPosition pos;
+
+	zend_hash_internal_pointer_reset_ex(plan, &pos);
+	for (;; zend_hash_move_forward_ex(plan, &pos)) {
+		char*                                field     = NULL;
+		uint                                 field_len = 0;
+		ulong                                num_key   = 0;
+		php_phongo_bson_hydrate_property_t** property;
+		zval**                               value;
+
+		if (zend_hash_get_current_key_ex(plan, &field, &field_len, &num_key, 0, &pos) != HASH_KEY_IS_STRING) {
+			break;
+		}
+
+		if (zend_hash_get_current_data_ex(plan, (void**) &property, &pos) == FAILURE) {
+			break;
+		}
+
+		if (zend_symtable_find(Z_ARRVAL_P(data), field, field_len, (void**) &value) == SUCCESS) {
+			zend_update_property(ce, object, (*property)->name, (*property)->name_len, *value TSRMLS_CC);
+		}
+	}
+} /* }}} */
+#endif
+
+/* Returns whether a string is valid UTF-8, with the same semantics as
+ * bson_utf8_validate(): overlong sequences, surrogates, and code points beyond
+ * U+10FFFF are rejected, and NUL bytes (including the two-byte encoding of NUL)
+ * are only accepted with allow_null. Runs of ASCII are skipped sixteen (with
+ * SSE2) or eight bytes at a time, so only multi-byte sequences are decoded. */
+bool php_phongo_bson_utf8_validate(const char* str, size_t len, bool allow_null) /* {{{ */
+{
+	const unsigned char* p   = (const unsigned char*) str;
+	const unsigned char* end = p + len;
+
+	if (!allow_null && memchr(str, '\0', len)) {
+		return false;
+	}
+
+	while (p < end) {
+		uint32_t code_point;
+		size_t   seq_len, i;
+
+#ifdef __SSE2__
+		while (end - p >= 16 && !_mm_movemask_epi8(_mm_loadu_si128((const __m128i*) p))) {
+			p += 16;
+		}
+#endif
+
+		while (end - p >= 8) {
+			uint64_t word;
+
+			memcpy(&word, p, sizeof(word));
+
+			if (word & UINT64_C(0x8080808080808080)) {
+				break;
+			}
+
+			p += 8;
+		}
+
+		while (p < end && *p < 0x80) {
+			p++;
+		}
+
+		if (p == end) {
+			break;
+		}
+
+		if ((*p & 0xE0) == 0xC0) {
+			seq_len    = 2;
+			code_point = *p & 0x1F;
+		} else if ((*p & 0xF0) == 0xE0) {
+			seq_len    = 3;
+			code_point = *p & 0x0F;
+		} else if ((*p & 0xF8) == 0xF0) {
+			seq_len    = 4;
+			code_point = *p & 0x07;
+		} else {
+			return false;
+		}
+
+		if ((size_t)(end - p) < seq_len) {
+			return false;
+		}
+
+		for (i = 1; i < seq_len; i++) {
+			if ((p[i] & 0xC0) != 0x80) {
+				return false;
+			}
+
+			code_point = (code_point << 6) | (p[i] & 0x3F);
+		}
+
+		if (code_point > 0x10FFFF || (code_point & 0xFFFFF800) == 0xD800) {
+			return false;
+		}
+
+		switch (seq_len) {
+			case 2:
+				if (code_point < 0x80 && (code_point != 0 || !allow_null)) {
+					return false;
+				}
+				break;
+
+			case 3:
+				if (code_point < 0x800) {
+					return false;
+				}
+				break;
+
+			default:
+				if (code_point < 0x10000) {
+					return false;
+				}
+		}
+
+		p += seq_len;
+	}
+
+	return true;
+} /* }}} */
+
+static void php_phongo_bson_visit_corrupt(const bson_iter_t* iter ARG_UNUSED, void* data ARG_UNUSED) /* {{{ */
+{
+	mongoc_log(MONGOC_LOG_LEVEL_WARNING, MONGOC_LOG_DOMAIN, "Corrupt BSON data detected!");
+} /* }}} */
+
+static void php_phongo_bson_visit_unsupported_type(const bson_iter_t* iter ARG_UNUSED, const char* key, uint32_t v_type_code, void* data ARG_UNUSED) /* {{{ */
+{
+	php_phongo_bson_state* state = (php_phongo_bson_state*) data;
+	char*                  path_string;
+	TSRMLS_FETCH();
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	path_string = php_phongo_field_path_as_string(state->field_path);
+
+	phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected unknown BSON type 0x%02hhx for field path \"%s\". Are you using the latest driver?", (unsigned char) v_type_code, path_string);
+
+	efree(path_string);
+} /* }}} */
+
+/* Initializes zchild with the representation of an ObjectId selected by the
+ * "types" type map key. */
+static void php_phongo_bson_new_oid(zval* zchild, php_phongo_bson_state* state, const bson_oid_t* v_oid TSRMLS_DC) /* {{{ */
+{
+	switch (state->map.objectid_type) {
+		case PHONGO_TYPEMAP_LEAF_STRING: {
+			char s_oid[25];
+
+			bson_oid_to_string(v_oid, s_oid);
+			PHONGO_BSON_ZVAL_STRINGL(zchild, s_oid, 24);
+			break;
+		}
+
+		case PHONGO_TYPEMAP_LEAF_BINARY:
+			PHONGO_BSON_ZVAL_STRINGL(zchild, (const char*) v_oid->bytes, sizeof(v_oid->bytes));
+			break;
+
+		default:
+			php_phongo_objectid_new_from_oid(zchild, v_oid TSRMLS_CC);
+	}
+} /* }}} */
+
+/* Initializes zchild with the representation of a UTCDateTime selected by the
+ * "types" type map key. */
+static void php_phongo_bson_new_date_time(zval* zchild, php_phongo_bson_state* state, int64_t msec_since_epoch TSRMLS_DC) /* {{{ */
+{
+	switch (state->map.utcdatetime_type) {
+		case PHONGO_TYPEMAP_LEAF_INT:
+#if SIZEOF_PHONGO_LONG == 4
+			if (msec_since_epoch > INT32_MAX || msec_since_epoch < INT32_MIN) {
+				php_phongo_new_int64(zchild, msec_since_epoch TSRMLS_CC);
+				break;
+			}
+#endif
+			ZVAL_LONG(zchild, (phongo_long) msec_since_epoch);
+			break;
+
+		case PHONGO_TYPEMAP_LEAF_DATETIME:
+			php_phongo_new_datetime_from_epoch(zchild, msec_since_epoch, php_phongo_date_immutable_ce TSRMLS_CC);
+			break;
+
+		default:
+			php_phongo_new_utcdatetime_from_epoch(zchild, msec_since_epoch TSRMLS_CC);
+	}
+} /* }}} */
+
+/* Initializes zchild with the representation of a Decimal128 selected by the
+ * "types" type map key. */
+static void php_phongo_bson_new_decimal128(zval* zchild, php_phongo_bson_state* state, const bson_decimal128_t* decimal TSRMLS_DC) /* {{{ */
+{
+	if (state->map.decimal128_type == PHONGO_TYPEMAP_LEAF_STRING) {
+		char s_decimal[BSON_DECIMAL128_STRING];
+
+		bson_decimal128_to_string(decimal, s_decimal);
+		PHONGO_BSON_ZVAL_STRINGL(zchild, s_decimal, strlen(s_decimal));
+		return;
+	}
+
+	php_phongo_new_decimal128(zchild, decimal TSRMLS_CC);
+} /* }}} */
+
+static bool php_phongo_bson_visit_double(const bson_iter_t* iter ARG_UNUSED, const char* key, double v_double, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+
+	if (state->is_visiting_array) {
+		add_next_index_double(retval, v_double);
+	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		ZVAL_DOUBLE(&zchild, v_double);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
+		add_assoc_double(retval, key, v_double);
+#endif
+	}
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_utf8(const bson_iter_t* iter ARG_UNUSED, const char* key, size_t v_utf8_len, const char* v_utf8, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+
+	if (state->is_visiting_array) {
+		ADD_NEXT_INDEX_STRINGL(retval, v_utf8, v_utf8_len);
+	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		ZVAL_STRINGL(&zchild, v_utf8, v_utf8_len);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
+		ADD_ASSOC_STRING_EX(retval, key, strlen(key), v_utf8, v_utf8_len);
+#endif
+	}
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_binary(const bson_iter_t* iter ARG_UNUSED, const char* key, bson_subtype_t v_subtype, size_t v_binary_len, const uint8_t* v_binary, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+	TSRMLS_FETCH();
+
+	if (v_subtype == 0x80 && strcmp(key, PHONGO_ODM_FIELD_NAME) == 0) {
+		php_phongo_bson_class_t* entry = php_phongo_bson_class_cache_find((const char*) v_binary, v_binary_len TSRMLS_CC);
+
+		if (entry && entry->is_persistable) {
+			((php_phongo_bson_state*) data)->odm = entry->ce;
+		}
+	}
+
+	{
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		/* Vectors are decoded straight into an array if requested by the type
+		 * map. Malformed vectors are left as Binary objects. */
+		if (!(v_subtype == PHONGO_BINARY_SUBTYPE_VECTOR && state->map.vector_as_array &&
+			  php_phongo_binary_vector_to_zval(v_binary, v_binary_len, &zchild TSRMLS_CC))) {
+			php_phongo_new_binary_from_binary_and_type(&zchild, (const char*) v_binary, v_binary_len, v_subtype TSRMLS_CC);
+		}
+
+		if (state->is_visiting_array) {
+			add_next_index_zval(retval, &zchild);
+		} else {
+			PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+		}
+#else  /* PHP_VERSION_ID >= 70000 */
+		zval*             zchild   = NULL;
+
+		MAKE_STD_ZVAL(zchild);
+
+		if (!(v_subtype == PHONGO_BINARY_SUBTYPE_VECTOR && state->map.vector_as_array &&
+			  php_phongo_binary_vector_to_zval(v_binary, v_binary_len, zchild TSRMLS_CC))) {
+			php_phongo_new_binary_from_binary_and_type(zchild, (const char*) v_binary, v_binary_len, v_subtype TSRMLS_CC);
+		}
+
+		if (state->is_visiting_array) {
+			add_next_index_zval(retval, zchild);
+		} else {
+			PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+		}
+#endif /* PHP_VERSION_ID >= 70000 */
+	}
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_undefined(const bson_iter_t* iter, const char* key, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000 /* PHP_VERSION_ID >= 70000 */
+	zval zchild;
+
+	object_init_ex(&zchild, php_phongo_undefined_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
+	TSRMLS_FETCH();
+
+	MAKE_STD_ZVAL(zchild);
+	object_init_ex(zchild, php_phongo_undefined_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_oid(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_oid_t* v_oid, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	php_phongo_bson_new_oid(&zchild, state, v_oid TSRMLS_CC);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
+	TSRMLS_FETCH();
+
+	MAKE_STD_ZVAL(zchild);
+	php_phongo_bson_new_oid(zchild, state, v_oid TSRMLS_CC);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_bool(const bson_iter_t* iter ARG_UNUSED, const char* key, bool v_bool, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+
+	if (state->is_visiting_array) {
+		add_next_index_bool(retval, v_bool);
+	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		ZVAL_BOOL(&zchild, v_bool);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
+		add_assoc_bool(retval, key, v_bool);
+#endif
+	}
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_date_time(const bson_iter_t* iter ARG_UNUSED, const char* key, int64_t msec_since_epoch, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	php_phongo_bson_new_date_time(&zchild, state, msec_since_epoch TSRMLS_CC);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
 	TSRMLS_FETCH();
 
 	MAKE_STD_ZVAL(zchild);
-	php_phongo_new_decimal128(zchild, decimal TSRMLS_CC);
+	php_phongo_bson_new_date_time(zchild, state, msec_since_epoch TSRMLS_CC);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_decimal128(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_decimal128_t* decimal, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	php_phongo_bson_new_decimal128(&zchild, state, decimal TSRMLS_CC);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
+	TSRMLS_FETCH();
+
+	MAKE_STD_ZVAL(zchild);
+	php_phongo_bson_new_decimal128(zchild, state, decimal TSRMLS_CC);
 
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -462,7 +1227,14 @@ static bool php_phongo_bson_visit_null(const bson_iter_t* iter ARG_UNUSED, const
 	if (state->is_visiting_array) {
 		add_next_index_null(retval);
 	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		ZVAL_NULL(&zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
 		add_assoc_null(retval, key);
+#endif
 	}
 
 	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
@@ -482,7 +1254,7 @@ static bool php_phongo_bson_visit_regex(const bson_iter_t* iter ARG_UNUSED, cons
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -494,7 +1266,7 @@ static bool php_phongo_bson_visit_regex(const bson_iter_t* iter ARG_UNUSED, cons
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -515,7 +1287,7 @@ static bool php_phongo_bson_visit_symbol(const bson_iter_t* iter, const char* ke
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -527,7 +1299,7 @@ static bool php_phongo_bson_visit_symbol(const bson_iter_t* iter, const char* ke
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -548,7 +1320,7 @@ static bool php_phongo_bson_visit_code(const bson_iter_t* iter ARG_UNUSED, const
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -560,7 +1332,7 @@ static bool php_phongo_bson_visit_code(const bson_iter_t* iter ARG_UNUSED, const
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -581,7 +1353,7 @@ static bool php_phongo_bson_visit_dbpointer(const bson_iter_t* iter, const char*
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -593,7 +1365,7 @@ static bool php_phongo_bson_visit_dbpointer(const bson_iter_t* iter, const char*
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -614,7 +1386,7 @@ static bool php_phongo_bson_visit_codewscope(const bson_iter_t* iter ARG_UNUSED,
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -626,7 +1398,7 @@ static bool php_phongo_bson_visit_codewscope(const bson_iter_t* iter ARG_UNUSED,
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -643,7 +1415,14 @@ static bool php_phongo_bson_visit_int32(const bson_iter_t* iter ARG_UNUSED, cons
 	if (state->is_visiting_array) {
 		add_next_index_long(retval, v_int32);
 	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+		ZVAL_LONG(&zchild, v_int32);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
 		add_assoc_long(retval, key, v_int32);
+#endif
 	}
 
 	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
@@ -663,7 +1442,7 @@ static bool php_phongo_bson_visit_timestamp(const bson_iter_t* iter ARG_UNUSED,
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, &zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
 	}
 #else  /* PHP_VERSION_ID >= 70000 */
 	zval* zchild = NULL;
@@ -675,7 +1454,7 @@ static bool php_phongo_bson_visit_timestamp(const bson_iter_t* iter ARG_UNUSED,
 	if (state->is_visiting_array) {
 		add_next_index_zval(retval, zchild);
 	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
 	}
 #endif /* PHP_VERSION_ID >= 70000 */
 
@@ -694,207 +1473,600 @@ static bool php_phongo_bson_visit_int64(const bson_iter_t* iter ARG_UNUSED, cons
 
 	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
 
+	if (state->map.int64_type == PHONGO_TYPEMAP_LEAF_STRING) {
+		char s_int64[24];
+		int  s_int64_len;
+
+		s_int64_len = snprintf(s_int64, sizeof(s_int64), "%" PRId64, v_int64);
+
+		if (state->is_visiting_array) {
+			ADD_NEXT_INDEX_STRINGL(retval, s_int64, s_int64_len);
+		} else {
+#if PHP_VERSION_ID >= 70000
+			zval zchild;
+
+			ZVAL_STRINGL(&zchild, s_int64, s_int64_len);
+			PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
+			ADD_ASSOC_STRING_EX(retval, key, strlen(key), s_int64, s_int64_len);
+#endif
+		}
+
+		return false;
+	}
+
 	if (state->is_visiting_array) {
 		ADD_NEXT_INDEX_INT64(retval, v_int64);
 	} else {
+#if PHP_VERSION_ID >= 70000
+		zval zchild;
+
+#if SIZEOF_PHONGO_LONG == 4
+		if (v_int64 > INT32_MAX || v_int64 < INT32_MIN) {
+			php_phongo_new_int64(&zchild, v_int64 TSRMLS_CC);
+		} else {
+			ZVAL_LONG(&zchild, (phongo_long) v_int64);
+		}
+#else
+		ZVAL_LONG(&zchild, v_int64);
+#endif
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+#else
 		ADD_ASSOC_INT64(retval, key, v_int64);
+#endif
+	}
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_maxkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	object_init_ex(&zchild, php_phongo_maxkey_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
+	TSRMLS_FETCH();
+
+	MAKE_STD_ZVAL(zchild);
+	object_init_ex(zchild, php_phongo_maxkey_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+static bool php_phongo_bson_visit_minkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
+{
+	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
+	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	object_init_ex(&zchild, php_phongo_minkey_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, &zchild);
+	}
+#else  /* PHP_VERSION_ID >= 70000 */
+	zval* zchild = NULL;
+	TSRMLS_FETCH();
+
+	MAKE_STD_ZVAL(zchild);
+	object_init_ex(zchild, php_phongo_minkey_ce);
+
+	if (state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(state, retval, key, zchild);
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+
+	return false;
+} /* }}} */
+
+/* Returns whether a field is kept by the projection type map key. Within
+ * arrays, elements are kept if they are documents or arrays, which the field
+ * paths can then descend into (as with server-side projections). */
+static bool php_phongo_bson_projection_keeps(php_phongo_bson_state* state, const bson_iter_t* iter, const char* key) /* {{{ */
+{
+	php_phongo_field_path_node* child;
+
+	if (state->projection_in_array) {
+		return BSON_ITER_HOLDS_DOCUMENT(iter) || BSON_ITER_HOLDS_ARRAY(iter);
+	}
+
+	for (child = state->projection->children; child; child = child->next) {
+		if (strcmp(child->name, key) == 0) {
+			return true;
+		}
 	}
 
 	return false;
 } /* }}} */
 
-static bool php_phongo_bson_visit_maxkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
+/* Returns the projection node to apply to an embedded document or array, or
+ * NULL if all of its fields are kept. */
+static php_phongo_field_path_node* php_phongo_bson_projection_descend(php_phongo_bson_state* parent_state, const char* key) /* {{{ */
+{
+	php_phongo_field_path_node* child;
+
+	if (!parent_state->projection) {
+		return NULL;
+	}
+
+	if (parent_state->projection_in_array) {
+		return parent_state->projection;
+	}
+
+	for (child = parent_state->projection->children; child; child = child->next) {
+		if (strcmp(child->name, key) == 0) {
+			return child->children ? child : NULL;
+		}
+	}
+
+	return NULL;
+} /* }}} */
+
+/* Visits the current field of a BSON iterator. Strings are validated with
+ * php_phongo_bson_utf8_validate(). Returns true if the visitor stopped
+ * iteration or the field is corrupt, in which case the iterator's error offset
+ * is set. */
+static bool php_phongo_bson_visit_field(bson_iter_t* iter, const char* key, php_phongo_bson_state* state) /* {{{ */
+{
+	switch (bson_iter_type(iter)) {
+		case BSON_TYPE_DOUBLE:
+			return php_phongo_bson_visit_double(iter, key, bson_iter_double(iter), state);
+
+		case BSON_TYPE_UTF8: {
+			uint32_t    utf8_len;
+			const char* utf8 = bson_iter_utf8(iter, &utf8_len);
+
+			if (!php_phongo_bson_utf8_validate(utf8, utf8_len, true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return php_phongo_bson_visit_utf8(iter, key, utf8_len, utf8, state);
+		}
+
+		case BSON_TYPE_DOCUMENT: {
+			const uint8_t* document     = NULL;
+			uint32_t       document_len = 0;
+			bson_t         b;
+
+			bson_iter_document(iter, &document_len, &document);
+
+			return bson_init_static(&b, document, document_len) && php_phongo_bson_visit_document(iter, key, &b, state);
+		}
+
+		case BSON_TYPE_ARRAY: {
+			const uint8_t* array     = NULL;
+			uint32_t       array_len = 0;
+			bson_t         b;
+
+			bson_iter_array(iter, &array_len, &array);
+
+			return bson_init_static(&b, array, array_len) && php_phongo_bson_visit_array(iter, key, &b, state);
+		}
+
+		case BSON_TYPE_BINARY: {
+			const uint8_t* binary     = NULL;
+			uint32_t       binary_len = 0;
+			bson_subtype_t subtype;
+
+			bson_iter_binary(iter, &subtype, &binary_len, &binary);
+
+			return php_phongo_bson_visit_binary(iter, key, subtype, binary_len, binary, state);
+		}
+
+		case BSON_TYPE_UNDEFINED:
+			return php_phongo_bson_visit_undefined(iter, key, state);
+
+		case BSON_TYPE_OID:
+			return php_phongo_bson_visit_oid(iter, key, bson_iter_oid(iter), state);
+
+		case BSON_TYPE_BOOL:
+			return php_phongo_bson_visit_bool(iter, key, bson_iter_bool(iter), state);
+
+		case BSON_TYPE_DATE_TIME:
+			return php_phongo_bson_visit_date_time(iter, key, bson_iter_date_time(iter), state);
+
+		case BSON_TYPE_NULL:
+			return php_phongo_bson_visit_null(iter, key, state);
+
+		case BSON_TYPE_REGEX: {
+			const char* options = NULL;
+			const char* regex   = bson_iter_regex(iter, &options);
+
+			if (!php_phongo_bson_utf8_validate(regex, strlen(regex), true) || !php_phongo_bson_utf8_validate(options, strlen(options), true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return php_phongo_bson_visit_regex(iter, key, regex, options, state);
+		}
+
+		case BSON_TYPE_DBPOINTER: {
+			uint32_t          collection_len;
+			const char*       collection;
+			const bson_oid_t* oid;
+
+			bson_iter_dbpointer(iter, &collection_len, &collection, &oid);
+
+			if (!php_phongo_bson_utf8_validate(collection, collection_len, true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return php_phongo_bson_visit_dbpointer(iter, key, collection_len, collection, oid, state);
+		}
+
+		case BSON_TYPE_CODE: {
+			uint32_t    code_len;
+			const char* code = bson_iter_code(iter, &code_len);
+
+			if (!php_phongo_bson_utf8_validate(code, code_len, true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return php_phongo_bson_visit_code(iter, key, code_len, code, state);
+		}
+
+		case BSON_TYPE_SYMBOL: {
+			uint32_t    symbol_len;
+			const char* symbol = bson_iter_symbol(iter, &symbol_len);
+
+			if (!php_phongo_bson_utf8_validate(symbol, symbol_len, true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return php_phongo_bson_visit_symbol(iter, key, symbol_len, symbol, state);
+		}
+
+		case BSON_TYPE_CODEWSCOPE: {
+			uint32_t       code_len;
+			const uint8_t* scope     = NULL;
+			uint32_t       scope_len = 0;
+			const char*    code      = bson_iter_codewscope(iter, &code_len, &scope_len, &scope);
+			bson_t         b;
+
+			if (!php_phongo_bson_utf8_validate(code, code_len, true)) {
+				iter->err_off = bson_iter_offset(iter);
+				return true;
+			}
+
+			return bson_init_static(&b, scope, scope_len) && php_phongo_bson_visit_codewscope(iter, key, code_len, code, &b, state);
+		}
+
+		case BSON_TYPE_INT32:
+			return php_phongo_bson_visit_int32(iter, key, bson_iter_int32(iter), state);
+
+		case BSON_TYPE_TIMESTAMP: {
+			uint32_t timestamp;
+			uint32_t increment;
+
+			bson_iter_timestamp(iter, &timestamp, &increment);
+
+			return php_phongo_bson_visit_timestamp(iter, key, timestamp, increment, state);
+		}
+
+		case BSON_TYPE_INT64:
+			return php_phongo_bson_visit_int64(iter, key, bson_iter_int64(iter), state);
+
+		case BSON_TYPE_DECIMAL128: {
+			bson_decimal128_t decimal;
+
+			bson_iter_decimal128(iter, &decimal);
+
+			return php_phongo_bson_visit_decimal128(iter, key, &decimal, state);
+		}
+
+		case BSON_TYPE_MAXKEY:
+			return php_phongo_bson_visit_maxkey(iter, key, state);
+
+		case BSON_TYPE_MINKEY:
+			return php_phongo_bson_visit_minkey(iter, key, state);
+
+		default:
+			return false;
+	}
+} /* }}} */
+
+/* Visitors for iterating over the fields of a document again after
+ * bson_iter_next() has stopped early. Only corrupt data and unsupported types
+ * are reported, since the fields were already visited. */
+static const bson_visitor_t php_phongo_bson_error_visitors = {
+	NULL /* php_phongo_bson_visit_before */,
+	NULL /* php_phongo_bson_visit_after */,
+	php_phongo_bson_visit_corrupt,
+	NULL /* php_phongo_bson_visit_double */,
+	NULL /* php_phongo_bson_visit_utf8 */,
+	NULL /* php_phongo_bson_visit_document */,
+	NULL /* php_phongo_bson_visit_array */,
+	NULL /* php_phongo_bson_visit_binary */,
+	NULL /* php_phongo_bson_visit_undefined */,
+	NULL /* php_phongo_bson_visit_oid */,
+	NULL /* php_phongo_bson_visit_bool */,
+	NULL /* php_phongo_bson_visit_date_time */,
+	NULL /* php_phongo_bson_visit_null */,
+	NULL /* php_phongo_bson_visit_regex */,
+	NULL /* php_phongo_bson_visit_dbpointer */,
+	NULL /* php_phongo_bson_visit_code */,
+	NULL /* php_phongo_bson_visit_symbol */,
+	NULL /* php_phongo_bson_visit_codewscope */,
+	NULL /* php_phongo_bson_visit_int32 */,
+	NULL /* php_phongo_bson_visit_timestamp */,
+	NULL /* php_phongo_bson_visit_int64 */,
+	NULL /* php_phongo_bson_visit_maxkey */,
+	NULL /* php_phongo_bson_visit_minkey */,
+	php_phongo_bson_visit_unsupported_type,
+	NULL /* php_phongo_bson_visit_decimal128 */,
+	{ NULL }
+};
+
+/* Visits all fields of a document or array, like bson_iter_visit_all() with
+ * the driver's visitors. Keys and strings are validated with
+ * php_phongo_bson_utf8_validate() instead of bson_utf8_validate(), which
+ * examines every byte individually. Fields excluded by the projection type map
+ * key are skipped before any zval is created for them. Returns true if
+ * iteration stopped prematurely, like bson_iter_visit_all().
+ *
+ * Only public libbson functions are used, and err_off is read the same way as
+ * after bson_iter_visit_all(). */
+static bool php_phongo_bson_iter_visit_all(bson_iter_t* iter, php_phongo_bson_state* state) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-#if PHP_VERSION_ID >= 70000
-	zval zchild;
+	bson_iter_t start = *iter;
 
-	object_init_ex(&zchild, php_phongo_maxkey_ce);
+	while (bson_iter_next(iter)) {
+		const char* key = bson_iter_key(iter);
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
-	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
-	TSRMLS_FETCH();
+		if (*key && !php_phongo_bson_utf8_validate(key, strlen(key), false)) {
+			iter->err_off = bson_iter_offset(iter);
+			php_phongo_bson_visit_corrupt(iter, state);
+			return false;
+		}
 
-	MAKE_STD_ZVAL(zchild);
-	object_init_ex(zchild, php_phongo_maxkey_ce);
+		if (state->projection && !php_phongo_bson_projection_keeps(state, iter, key)) {
+			continue;
+		}
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+		if (php_phongo_bson_visit_field(iter, key, state)) {
+			return true;
+		}
 	}
-#endif /* PHP_VERSION_ID >= 70000 */
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	/* bson_iter_next() does not report whether it stopped at corrupt data or
+	 * an unsupported type. In either case, bson_iter_visit_all() walks the
+	 * fields again without visiting them and reports the error. */
+	if (iter->err_off && bson_iter_visit_all(&start, &php_phongo_bson_error_visitors, state)) {
+		php_phongo_bson_visit_corrupt(iter, state);
+	}
 
 	return false;
 } /* }}} */
 
-static bool php_phongo_bson_visit_minkey(const bson_iter_t* iter ARG_UNUSED, const char* key, void* data) /* {{{ */
+/* Descends one level into the fieldPaths trie for the given key, starting from
+ * the nodes matched by the parent state. If a field path ends at this level,
+ * the type and ce arguments are overridden with its type map entry. Nodes which
+ * may match deeper levels are returned through the nodes argument, which must
+ * be freed by the caller if a non-zero count is returned. */
+static size_t php_phongo_field_path_map_descend(php_phongo_bson_state* parent_state, const char* key, php_phongo_field_path_node*** nodes, php_phongo_bson_typemap_types* type, zend_class_entry** ce) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	php_phongo_bson_state* state  = (php_phongo_bson_state*) data;
-#if PHP_VERSION_ID >= 70000
-	zval zchild;
+	php_phongo_field_path_node* match = NULL;
+	size_t                      count = 0;
+	size_t                      i;
 
-	object_init_ex(&zchild, php_phongo_minkey_ce);
+	*nodes = NULL;
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, &zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, &zchild);
+	if (!parent_state->field_path_nodes_count) {
+		return 0;
 	}
-#else  /* PHP_VERSION_ID >= 70000 */
-	zval* zchild = NULL;
-	TSRMLS_FETCH();
 
-	MAKE_STD_ZVAL(zchild);
-	object_init_ex(zchild, php_phongo_minkey_ce);
+	/* Sibling names are unique, so each parent node can match at most one
+	 * named child and one wildcard child. */
+	*nodes = emalloc(sizeof(php_phongo_field_path_node*) * parent_state->field_path_nodes_count * 2);
 
-	if (state->is_visiting_array) {
-		add_next_index_zval(retval, zchild);
-	} else {
-		ADD_ASSOC_ZVAL(retval, key, zchild);
+	for (i = 0; i < parent_state->field_path_nodes_count; i++) {
+		php_phongo_field_path_node* child;
+
+		for (child = parent_state->field_path_nodes[i]->children; child; child = child->next) {
+			if (strcmp(child->name, "$") != 0 && strcmp(child->name, key) != 0) {
+				continue;
+			}
+
+			if (child->node_type != PHONGO_TYPEMAP_NONE && (!match || child->order < match->order)) {
+				match = child;
+			}
+
+			if (child->children) {
+				(*nodes)[count++] = child;
+			}
+		}
 	}
-#endif /* PHP_VERSION_ID >= 70000 */
 
-	php_phongo_field_path_write_item_at_current_level(state->field_path, key);
+	if (match) {
+		*type = match->node_type;
+		*ce   = match->node_ce;
+	}
 
-	return false;
-} /* }}} */
+	if (!count) {
+		efree(*nodes);
+		*nodes = NULL;
+	}
 
-static const bson_visitor_t php_bson_visitors = {
-	NULL /* php_phongo_bson_visit_before*/,
-	NULL /*php_phongo_bson_visit_after*/,
-	php_phongo_bson_visit_corrupt,
-	php_phongo_bson_visit_double,
-	php_phongo_bson_visit_utf8,
-	php_phongo_bson_visit_document,
-	php_phongo_bson_visit_array,
-	php_phongo_bson_visit_binary,
-	php_phongo_bson_visit_undefined,
-	php_phongo_bson_visit_oid,
-	php_phongo_bson_visit_bool,
-	php_phongo_bson_visit_date_time,
-	php_phongo_bson_visit_null,
-	php_phongo_bson_visit_regex,
-	php_phongo_bson_visit_dbpointer,
-	php_phongo_bson_visit_code,
-	php_phongo_bson_visit_symbol,
-	php_phongo_bson_visit_codewscope,
-	php_phongo_bson_visit_int32,
-	php_phongo_bson_visit_timestamp,
-	php_phongo_bson_visit_int64,
-	php_phongo_bson_visit_maxkey,
-	php_phongo_bson_visit_minkey,
-	php_phongo_bson_visit_unsupported_type,
-	php_phongo_bson_visit_decimal128,
-	{ NULL }
-};
+	return count;
+} /* }}} */
 
-static inline bool map_element_matches_field_path(php_phongo_field_path_map_element* map_element, php_phongo_field_path* current)
+/* Initializes the array for a decoded document or array with room for all of
+ * its fields, so that visitors never have to grow it. Arrays are initialized as
+ * packed tables on PHP 7. If a projection applies, most fields may be skipped,
+ * so the default size is used instead. */
+static void php_phongo_bson_array_init(zval* zv, const bson_t* bson, bool is_array, php_phongo_field_path_node* projection) /* {{{ */
 {
-	size_t i;
+	uint32_t count;
 
-	if (map_element->entry->size != current->size) {
-		return false;
+	if (projection) {
+		array_init(zv);
+		return;
 	}
-	for (i = 0; i < current->size; i++) {
-		if (strcmp(map_element->entry->elements[i], "$") == 0) {
-			continue;
-		}
-		if (strcmp(map_element->entry->elements[i], current->elements[i]) != 0) {
-			return false;
-		}
+
+	count = bson_count_keys(bson);
+
+	array_init_size(zv, count);
+
+#if PHP_VERSION_ID >= 70000
+	if (is_array && count) {
+		zend_hash_real_init(Z_ARRVAL_P(zv), 1);
 	}
-	return true;
-}
+#endif
+} /* }}} */
 
-static php_phongo_field_path_map_element* map_find_field_path_entry(php_phongo_bson_state* state)
+/* Appends a MongoDB\BSON\Document wrapping the raw BSON of an embedded
+ * document or array to the parent zval, without visiting its fields. */
+static void php_phongo_bson_append_lazy_document(zval* retval, php_phongo_bson_state* parent_state, const char* key, const bson_t* v_document) /* {{{ */
 {
-	size_t i;
+	TSRMLS_FETCH();
 
-	/* Loop over all field path mappings, and for each, try to see whether it matches the current path */
-	for (i = 0; i < state->map.field_paths.size; i++) {
-		if (map_element_matches_field_path(state->map.field_paths.map[i], state->field_path)) {
-			return state->map.field_paths.map[i];
+#if PHP_VERSION_ID >= 70000
+	{
+		zval zchild;
+
+		php_phongo_new_document_from_bson(&zchild, bson_get_data(v_document), v_document->len TSRMLS_CC);
+
+		if (parent_state->is_visiting_array) {
+			add_next_index_zval(retval, &zchild);
+		} else {
+			PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &zchild);
 		}
 	}
-	return NULL;
-}
+#else  /* PHP_VERSION_ID >= 70000 */
+	{
+		zval* zchild = NULL;
 
-static void php_phongo_handle_field_path_entry_for_compound_type(php_phongo_bson_state* state, php_phongo_bson_typemap_types* type, zend_class_entry** ce)
-{
-	php_phongo_field_path_map_element* entry = map_find_field_path_entry(state);
+		MAKE_STD_ZVAL(zchild);
+		php_phongo_new_document_from_bson(zchild, bson_get_data(v_document), v_document->len TSRMLS_CC);
 
-	if (entry) {
-		switch (entry->node_type) {
-			case PHONGO_TYPEMAP_NATIVE_ARRAY:
-			case PHONGO_TYPEMAP_NATIVE_OBJECT:
-				*type = entry->node_type;
-				break;
-			case PHONGO_TYPEMAP_CLASS:
-				*type = entry->node_type;
-				*ce   = entry->node_ce;
-				break;
-			default:
-				/* Do nothing - pacify compiler */
-				break;
+		if (parent_state->is_visiting_array) {
+			add_next_index_zval(retval, zchild);
+		} else {
+			PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, zchild);
 		}
 	}
-}
+#endif /* PHP_VERSION_ID >= 70000 */
+} /* }}} */
 
 static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_document, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	bson_iter_t            child;
-	php_phongo_bson_state* parent_state = (php_phongo_bson_state*) data;
+	zval*                         retval = PHONGO_BSON_STATE_ZCHILD(data);
+	bson_iter_t                   child;
+	php_phongo_bson_state*        parent_state = (php_phongo_bson_state*) data;
+	php_phongo_bson_typemap_types document_type;
+	zend_class_entry*             document_ce;
+	php_phongo_field_path_node**  nodes;
+	size_t                        nodes_count;
+	HashTable*                    hydrate_plan = NULL;
 	TSRMLS_FETCH();
 
+	if (php_phongo_bson_state_skips_field(parent_state, key)) {
+		return false;
+	}
+
 	php_phongo_field_path_push(parent_state->field_path, key, PHONGO_FIELD_PATH_ITEM_DOCUMENT);
 
+	/* Check for entries in the fieldPath type map key, and use them to override
+	 * the default ones for this type. This is done before visiting, since
+	 * documents mapped to MongoDB\BSON\Document are not visited at all. */
+	document_type = parent_state->map.document_type;
+	document_ce   = parent_state->map.document;
+	nodes_count   = php_phongo_field_path_map_descend(parent_state, key, &nodes, &document_type, &document_ce);
+
+	if (document_type == PHONGO_TYPEMAP_BSON) {
+		php_phongo_bson_append_lazy_document(retval, parent_state, key, v_document);
+		php_phongo_field_path_pop(parent_state->field_path);
+
+		if (nodes) {
+			efree(nodes);
+		}
+
+		return false;
+	}
+
+	if (document_type == PHONGO_TYPEMAP_HYDRATE && !(hydrate_plan = php_phongo_bson_hydrate_plan(document_ce TSRMLS_CC))) {
+		php_phongo_field_path_pop(parent_state->field_path);
+
+		if (nodes) {
+			efree(nodes);
+		}
+
+		return true;
+	}
+
 	if (bson_iter_init(&child, v_document)) {
 		php_phongo_bson_state state = PHONGO_BSON_STATE_INITIALIZER;
 
 		php_phongo_bson_state_copy_ctor(&state, parent_state);
+		state.field_path_nodes       = nodes;
+		state.field_path_nodes_count = nodes_count;
+		state.projection             = php_phongo_bson_projection_descend(parent_state, key);
 
 #if PHP_VERSION_ID >= 70000
-		array_init(&state.zchild);
+		/* Hydrated objects are created up front, so that visitors can write
+		 * values directly to their properties */
+		if (hydrate_plan) {
+			object_init_ex(&state.zchild, document_ce);
+			state.hydrate_plan = hydrate_plan;
+			state.hydrate_ce   = document_ce;
+		} else {
+			php_phongo_bson_array_init(&state.zchild, v_document, false, state.projection);
+		}
 #else
 		MAKE_STD_ZVAL(state.zchild);
-		array_init(state.zchild);
+		php_phongo_bson_array_init(state.zchild, v_document, false, state.projection);
 #endif
 
-		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off) {
-			/* Check for entries in the fieldPath type map key, and use them to
-			 * override the default ones for this type */
-			php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.document_type, &state.map.document);
-
+		if (!php_phongo_bson_iter_visit_all(&child, &state) && !child.err_off) {
 			/* If php_phongo_bson_visit_binary() finds an ODM class, it should
 			 * supersede a default type map and named document class. */
-			if (state.odm && state.map.document_type == PHONGO_TYPEMAP_NONE) {
-				state.map.document_type = PHONGO_TYPEMAP_CLASS;
+			if (state.odm && document_type == PHONGO_TYPEMAP_NONE) {
+				document_type = PHONGO_TYPEMAP_CLASS;
 			}
 
-			switch (state.map.document_type) {
+			switch (document_type) {
 				case PHONGO_TYPEMAP_NATIVE_ARRAY:
 #if PHP_VERSION_ID >= 70000
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, &state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
 					}
 #else  /* PHP_VERSION_ID >= 70000 */
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, state.zchild);
 					}
 #endif /* PHP_VERSION_ID >= 70000 */
 					break;
@@ -903,24 +2075,47 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 #if PHP_VERSION_ID >= 70000
 					zval obj;
 
-					object_init_ex(&obj, state.odm ? state.odm : state.map.document);
-					zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state.zchild);
+					object_init_ex(&obj, state.odm ? state.odm : document_ce);
+					php_phongo_bson_unserialize(&obj, state.odm ? state.odm : document_ce, &state.zchild TSRMLS_CC);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, &obj);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &obj);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &obj);
+					}
+					zval_ptr_dtor(&state.zchild);
+#else  /* PHP_VERSION_ID >= 70000 */
+					zval* obj = NULL;
+
+					MAKE_STD_ZVAL(obj);
+					object_init_ex(obj, state.odm ? state.odm : document_ce);
+					php_phongo_bson_unserialize(obj, state.odm ? state.odm : document_ce, state.zchild TSRMLS_CC);
+					if (((php_phongo_bson_state*) data)->is_visiting_array) {
+						add_next_index_zval(retval, obj);
+					} else {
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, obj);
 					}
 					zval_ptr_dtor(&state.zchild);
+#endif /* PHP_VERSION_ID >= 70000 */
+					break;
+				}
+
+				case PHONGO_TYPEMAP_HYDRATE: {
+#if PHP_VERSION_ID >= 70000
+					if (((php_phongo_bson_state*) data)->is_visiting_array) {
+						add_next_index_zval(retval, &state.zchild);
+					} else {
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
+					}
 #else  /* PHP_VERSION_ID >= 70000 */
 					zval* obj = NULL;
 
 					MAKE_STD_ZVAL(obj);
-					object_init_ex(obj, state.odm ? state.odm : state.map.document);
-					zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, state.zchild);
+					object_init_ex(obj, document_ce);
+					php_phongo_bson_hydrate_object(obj, document_ce, hydrate_plan, state.zchild TSRMLS_CC);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, obj);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, obj);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, obj);
 					}
 					zval_ptr_dtor(&state.zchild);
 #endif /* PHP_VERSION_ID >= 70000 */
@@ -934,14 +2129,14 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, &state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
 					}
 #else  /* PHP_VERSION_ID >= 70000 */
 					convert_to_object(state.zchild);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, state.zchild);
 					}
 #endif /* PHP_VERSION_ID >= 70000 */
 			}
@@ -951,6 +2146,11 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 			 * true to stop iteration for our parent context. */
 			zval_ptr_dtor(&state.zchild);
 			php_phongo_bson_state_dtor(&state);
+
+			if (nodes) {
+				efree(nodes);
+			}
+
 			return true;
 		}
 
@@ -958,22 +2158,202 @@ static bool php_phongo_bson_visit_document(const bson_iter_t* iter ARG_UNUSED, c
 		php_phongo_field_path_pop(parent_state->field_path);
 	}
 
+	if (nodes) {
+		efree(nodes);
+	}
+
 	return false;
 } /* }}} */
 
+/* Decodes a BSON array whose elements are all doubles or integers directly
+ * into a PHP array, which avoids a visitor callback for each element. Returns
+ * false without modifying the output argument if the array is empty, contains
+ * other types, or is corrupt; the array should then be visited. */
+static bool php_phongo_bson_decode_numeric_array(const bson_t* v_array, zval* out) /* {{{ */
+{
+	bson_iter_t iter;
+	uint32_t    count = 0;
+
+	if (!bson_iter_init(&iter, v_array)) {
+		return false;
+	}
+
+	while (bson_iter_next(&iter)) {
+		switch (bson_iter_type(&iter)) {
+			case BSON_TYPE_DOUBLE:
+			case BSON_TYPE_INT32:
+#if SIZEOF_PHONGO_LONG == 8
+			case BSON_TYPE_INT64:
+#endif
+				count++;
+				break;
+
+			default:
+				return false;
+		}
+	}
+
+	if (iter.err_off || count == 0) {
+		return false;
+	}
+
+	bson_iter_init(&iter, v_array);
+
+#if PHP_VERSION_ID >= 70000
+	array_init_size(out, count);
+	zend_hash_real_init(Z_ARRVAL_P(out), 1);
+
+	ZEND_HASH_FILL_PACKED(Z_ARRVAL_P(out))
+	{
+		while (bson_iter_next(&iter)) {
+			zval value;
+
+			switch (bson_iter_type(&iter)) {
+				case BSON_TYPE_DOUBLE:
+					ZVAL_DOUBLE(&value, bson_iter_double(&iter));
+					break;
+
+				case BSON_TYPE_INT32:
+					ZVAL_LONG(&value, bson_iter_int32(&iter));
+					break;
+
+				default:
+					ZVAL_LONG(&value, bson_iter_int64(&iter));
+			}
+
+			ZEND_HASH_FILL_ADD(&value);
+		}
+	}
+	ZEND_HASH_FILL_END();
+#else
+	array_init_size(out, count);
+
+	while (bson_iter_next(&iter)) {
+		switch (bson_iter_type(&iter)) {
+			case BSON_TYPE_DOUBLE:
+				add_next_index_double(out, bson_iter_double(&iter));
+				break;
+
+			case BSON_TYPE_INT32:
+				add_next_index_long(out, bson_iter_int32(&iter));
+				break;
+
+			default:
+				add_next_index_long(out, bson_iter_int64(&iter));
+		}
+	}
+#endif
+
+	return true;
+} /* }}} */
+
+/* Appends a BSON array of numbers to the parent's value as a PHP array, if it
+ * can be decoded by php_phongo_bson_decode_numeric_array(). */
+static bool php_phongo_bson_append_numeric_array(zval* retval, php_phongo_bson_state* parent_state, const char* key, const bson_t* v_array) /* {{{ */
+{
+#if PHP_VERSION_ID >= 70000
+	zval zchild;
+
+	if (!php_phongo_bson_decode_numeric_array(v_array, &zchild)) {
+		return false;
+	}
+
+	if (parent_state->is_visiting_array) {
+		add_next_index_zval(retval, &zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &zchild);
+	}
+#else
+	zval* zchild = NULL;
+
+	MAKE_STD_ZVAL(zchild);
+
+	if (!php_phongo_bson_decode_numeric_array(v_array, zchild)) {
+		FREE_ZVAL(zchild);
+		return false;
+	}
+
+	if (parent_state->is_visiting_array) {
+		add_next_index_zval(retval, zchild);
+	} else {
+		PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, zchild);
+	}
+#endif
+
+	return true;
+} /* }}} */
+
 static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, const char* key, const bson_t* v_array, void* data) /* {{{ */
 {
-	zval*                  retval = PHONGO_BSON_STATE_ZCHILD(data);
-	bson_iter_t            child;
-	php_phongo_bson_state* parent_state = (php_phongo_bson_state*) data;
+	zval*                         retval = PHONGO_BSON_STATE_ZCHILD(data);
+	bson_iter_t                   child;
+	php_phongo_bson_state*        parent_state = (php_phongo_bson_state*) data;
+	php_phongo_bson_typemap_types array_type;
+	zend_class_entry*             array_ce;
+	php_phongo_field_path_node**  nodes;
+	size_t                        nodes_count;
+	php_phongo_field_path_node*   projection;
+	HashTable*                    hydrate_plan = NULL;
 	TSRMLS_FETCH();
 
+	if (php_phongo_bson_state_skips_field(parent_state, key)) {
+		return false;
+	}
+
 	php_phongo_field_path_push(parent_state->field_path, key, PHONGO_FIELD_PATH_ITEM_ARRAY);
 
+	/* Check for entries in the fieldPath type map key, and use them to override
+	 * the default ones for this type */
+	array_type  = parent_state->map.array_type;
+	array_ce    = parent_state->map.array;
+	nodes_count = php_phongo_field_path_map_descend(parent_state, key, &nodes, &array_type, &array_ce);
+
+	if (array_type == PHONGO_TYPEMAP_BSON) {
+		php_phongo_bson_append_lazy_document(retval, parent_state, key, v_array);
+		php_phongo_field_path_pop(parent_state->field_path);
+
+		if (nodes) {
+			efree(nodes);
+		}
+
+		return false;
+	}
+
+	if (array_type == PHONGO_TYPEMAP_HYDRATE && !(hydrate_plan = php_phongo_bson_hydrate_plan(array_ce TSRMLS_CC))) {
+		php_phongo_field_path_pop(parent_state->field_path);
+
+		if (nodes) {
+			efree(nodes);
+		}
+
+		return true;
+	}
+
+	projection = php_phongo_bson_projection_descend(parent_state, key);
+
+	/* Arrays of numbers that will be returned as PHP arrays are decoded in a
+	 * single pass. Their elements cannot match any field paths, but would be
+	 * excluded by a projection descending into the array. The fast path always
+	 * decodes int64 values to integers, so it cannot be used if the "types"
+	 * type map key selects another representation for them. */
+	if ((array_type == PHONGO_TYPEMAP_NONE || array_type == PHONGO_TYPEMAP_NATIVE_ARRAY) && !projection && parent_state->map.int64_type != PHONGO_TYPEMAP_LEAF_STRING && php_phongo_bson_append_numeric_array(retval, parent_state, key, v_array)) {
+		php_phongo_field_path_pop(parent_state->field_path);
+
+		if (nodes) {
+			efree(nodes);
+		}
+
+		return false;
+	}
+
 	if (bson_iter_init(&child, v_array)) {
 		php_phongo_bson_state state = PHONGO_BSON_STATE_INITIALIZER;
 
 		php_phongo_bson_state_copy_ctor(&state, parent_state);
+		state.field_path_nodes       = nodes;
+		state.field_path_nodes_count = nodes_count;
+		state.projection             = projection;
+		state.projection_in_array    = projection != NULL;
 
 		/* Note that we are visiting an array, so element visitors know to use
 		 * add_next_index() (i.e. disregard BSON keys) instead of add_assoc()
@@ -982,40 +2362,69 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 		state.is_visiting_array = true;
 
 #if PHP_VERSION_ID >= 70000
-		array_init(&state.zchild);
+		/* Hydrated objects are created up front, so that visitors can write
+		 * values directly to their properties. The element's index is then
+		 * used as its field name. */
+		if (hydrate_plan) {
+			object_init_ex(&state.zchild, array_ce);
+			state.hydrate_plan      = hydrate_plan;
+			state.hydrate_ce        = array_ce;
+			state.is_visiting_array = false;
+		} else {
+			php_phongo_bson_array_init(&state.zchild, v_array, true, state.projection);
+		}
 #else
 		MAKE_STD_ZVAL(state.zchild);
-		array_init(state.zchild);
+		php_phongo_bson_array_init(state.zchild, v_array, true, state.projection);
 #endif
 
-		if (!bson_iter_visit_all(&child, &php_bson_visitors, &state) && !child.err_off) {
-			/* Check for entries in the fieldPath type map key, and use them to
-			 * override the default ones for this type */
-			php_phongo_handle_field_path_entry_for_compound_type(&state, &state.map.array_type, &state.map.array);
+		if (!php_phongo_bson_iter_visit_all(&child, &state) && !child.err_off) {
+			switch (array_type) {
+				case PHONGO_TYPEMAP_CLASS: {
+#if PHP_VERSION_ID >= 70000
+					zval obj;
+
+					object_init_ex(&obj, array_ce);
+					php_phongo_bson_unserialize(&obj, array_ce, &state.zchild TSRMLS_CC);
+					if (((php_phongo_bson_state*) data)->is_visiting_array) {
+						add_next_index_zval(retval, &obj);
+					} else {
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &obj);
+					}
+					zval_ptr_dtor(&state.zchild);
+#else  /* PHP_VERSION_ID >= 70000 */
+					zval* obj = NULL;
+
+					MAKE_STD_ZVAL(obj);
+					object_init_ex(obj, array_ce);
+					php_phongo_bson_unserialize(obj, array_ce, state.zchild TSRMLS_CC);
+					if (((php_phongo_bson_state*) data)->is_visiting_array) {
+						add_next_index_zval(retval, obj);
+					} else {
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, obj);
+					}
+					zval_ptr_dtor(&state.zchild);
+#endif /* PHP_VERSION_ID >= 70000 */
+					break;
+				}
 
-			switch (state.map.array_type) {
-				case PHONGO_TYPEMAP_CLASS: {
+				case PHONGO_TYPEMAP_HYDRATE: {
 #if PHP_VERSION_ID >= 70000
-					zval obj;
-
-					object_init_ex(&obj, state.map.array);
-					zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state.zchild);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
-						add_next_index_zval(retval, &obj);
+						add_next_index_zval(retval, &state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &obj);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
 					}
-					zval_ptr_dtor(&state.zchild);
 #else  /* PHP_VERSION_ID >= 70000 */
 					zval* obj = NULL;
 
 					MAKE_STD_ZVAL(obj);
-					object_init_ex(obj, state.map.array);
-					zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, state.zchild);
+					object_init_ex(obj, array_ce);
+					php_phongo_bson_hydrate_object(obj, array_ce, hydrate_plan, state.zchild TSRMLS_CC);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, obj);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, obj);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, obj);
 					}
 					zval_ptr_dtor(&state.zchild);
 #endif /* PHP_VERSION_ID >= 70000 */
@@ -1028,14 +2437,14 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, &state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
 					}
 #else  /* PHP_VERSION_ID >= 70000 */
 					convert_to_object(state.zchild);
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, state.zchild);
 					}
 #endif /* PHP_VERSION_ID >= 70000 */
 					break;
@@ -1046,13 +2455,13 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, &state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, &state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, &state.zchild);
 					}
 #else  /* PHP_VERSION_ID >= 70000 */
 					if (((php_phongo_bson_state*) data)->is_visiting_array) {
 						add_next_index_zval(retval, state.zchild);
 					} else {
-						ADD_ASSOC_ZVAL(retval, key, state.zchild);
+						PHONGO_BSON_ADD_ASSOC_ZVAL(parent_state, retval, key, state.zchild);
 					}
 #endif /* PHP_VERSION_ID >= 70000 */
 					break;
@@ -1063,6 +2472,11 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 			 * true to stop iteration for our parent context. */
 			zval_ptr_dtor(&state.zchild);
 			php_phongo_bson_state_dtor(&state);
+
+			if (nodes) {
+				efree(nodes);
+			}
+
 			return true;
 		}
 
@@ -1070,6 +2484,10 @@ static bool php_phongo_bson_visit_array(const bson_iter_t* iter ARG_UNUSED, cons
 		php_phongo_field_path_pop(parent_state->field_path);
 	}
 
+	if (nodes) {
+		efree(nodes);
+	}
+
 	return false;
 } /* }}} */
 
@@ -1093,6 +2511,129 @@ bool php_phongo_bson_to_zval(const unsigned char* data, int data_len, zval** zv)
 	return retval;
 } /* }}} */
 
+#if PHP_VERSION_ID >= 70000
+/* Returns whether the fields of a document have the same names and order as
+ * the buckets of the previous document's property table, taking any fields
+ * skipped by the projection type map key into account. This only iterates over
+ * the document, so nothing is decoded (and no userland code is called) unless
+ * the previous document can be recycled. */
+static bool php_phongo_bson_recycle_matches(php_phongo_bson_state* state, const bson_t* b, HashTable* ht) /* {{{ */
+{
+	bson_iter_t iter;
+	uint32_t    pos = 0;
+
+	if (ht->nNumUsed != ht->nNumOfElements || !bson_iter_init(&iter, b)) {
+		return false;
+	}
+
+	while (bson_iter_next(&iter)) {
+		const char* key     = bson_iter_key(&iter);
+		size_t      key_len = strlen(key);
+		Bucket*     bucket;
+
+		if (state->projection && !php_phongo_bson_projection_keeps(state, &iter, key)) {
+			continue;
+		}
+
+		/* An ODM class would supersede the stdClass root */
+		if (BSON_ITER_HOLDS_BINARY(&iter) && strcmp(key, PHONGO_ODM_FIELD_NAME) == 0) {
+			return false;
+		}
+
+		if (pos >= ht->nNumUsed) {
+			return false;
+		}
+
+		bucket = ht->arData + pos++;
+
+		if (!bucket->key || ZSTR_LEN(bucket->key) != key_len || memcmp(ZSTR_VAL(bucket->key), key, key_len) != 0) {
+			return false;
+		}
+	}
+
+	return !iter.err_off && pos == ht->nNumUsed;
+} /* }}} */
+#endif
+
+/* Decodes a BSON document into the stdClass object left in the state by the
+ * previous call, overwriting its values in place. This avoids allocating a new
+ * object and HashTable for each document when iterating over documents of the
+ * same shape.
+ *
+ * Recycling is only possible on PHP 7, for the default and object type maps,
+ * and if the fields of both documents have the same names and order. The
+ * property table must not be shared, since it is modified in place. Arrays are
+ * never recycled: while iterating, the previous array is still referenced by
+ * the loop variable, and reusing it would not be observable anyway.
+ *
+ * If false is returned, the previous document was left untouched and the
+ * caller should free it and use php_phongo_bson_to_zval_ex() instead.
+ * Otherwise, the document was decoded in place. If decoding failed, an
+ * exception will have been thrown as with php_phongo_bson_to_zval_ex(), and
+ * the previous document may have been partially overwritten. */
+bool php_phongo_bson_to_zval_recycle(const unsigned char* data, int data_len, php_phongo_bson_state* state) /* {{{ */
+{
+#if PHP_VERSION_ID >= 70000
+	bson_t                      b;
+	bson_iter_t                 iter;
+	HashTable*                  ht;
+	php_phongo_field_path_node* root_node;
+
+	if (state->map.root_type != PHONGO_TYPEMAP_NONE && state->map.root_type != PHONGO_TYPEMAP_NATIVE_OBJECT) {
+		return false;
+	}
+
+	if (Z_TYPE(state->zchild) != IS_OBJECT || Z_OBJCE(state->zchild) != zend_standard_class_def || !(ht = Z_OBJ(state->zchild)->properties)) {
+		return false;
+	}
+
+	/* The cursor and the foreach variable are the only references a streaming
+	 * loop holds. Objects retained anywhere else must keep their values. */
+	if (GC_REFCOUNT(Z_OBJ(state->zchild)) > 2 || GC_REFCOUNT(ht) > 1) {
+		return false;
+	}
+
+	if (!bson_init_static(&b, data, data_len) || !bson_iter_init(&iter, &b)) {
+		return false;
+	}
+
+	if (state->map.projection_map.children) {
+		state->projection = &state->map.projection_map;
+	}
+
+	if (!php_phongo_bson_recycle_matches(state, &b, ht)) {
+		state->projection = NULL;
+		return false;
+	}
+
+	if (state->map.field_path_map.children) {
+		root_node                     = &state->map.field_path_map;
+		state->field_path_nodes       = &root_node;
+		state->field_path_nodes_count = 1;
+	}
+
+	state->recycle_ht  = ht;
+	state->recycle_pos = 0;
+
+	if (php_phongo_bson_iter_visit_all(&iter, state) || iter.err_off) {
+		if (!EG(exception)) {
+			char* path = php_phongo_field_path_as_string(state->field_path);
+			phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Detected corrupt BSON data for field path '%s' at offset %d", path, iter.err_off);
+			efree(path);
+		}
+	}
+
+	state->field_path_nodes       = NULL;
+	state->field_path_nodes_count = 0;
+	state->projection             = NULL;
+	state->recycle_ht             = NULL;
+
+	return true;
+#else
+	return false;
+#endif
+} /* }}} */
+
 /* Converts a BSON document to a PHP value according to the typemap specified in
  * the state argument.
  *
@@ -1107,12 +2648,14 @@ bool php_phongo_bson_to_zval(const unsigned char* data, int data_len, zval** zv)
  */
 bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_phongo_bson_state* state) /* {{{ */
 {
-	bson_reader_t* reader = NULL;
-	bson_iter_t    iter;
-	const bson_t*  b;
-	bool           eof             = false;
-	bool           retval          = false;
-	bool           must_dtor_state = false;
+	bson_reader_t*              reader = NULL;
+	bson_iter_t                 iter;
+	const bson_t*               b;
+	bool                        eof             = false;
+	bool                        retval          = false;
+	bool                        must_dtor_state = false;
+	php_phongo_field_path_node* root_node;
+	HashTable*                  hydrate_plan = NULL;
 	TSRMLS_FETCH();
 
 #if PHP_VERSION_ID < 70000
@@ -1143,16 +2686,49 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 		goto cleanup;
 	}
 
+	/* A root type of MongoDB\BSON\Document wraps the raw BSON, so there is
+	 * nothing to visit. Fields will be decoded as they are accessed. */
+	if (state->map.root_type == PHONGO_TYPEMAP_BSON) {
+		php_phongo_new_document_from_bson(PHONGO_BSON_STATE_ZCHILD(state), bson_get_data(b), b->len TSRMLS_CC);
+
+		goto check_eof;
+	}
+
+	if (state->map.root_type == PHONGO_TYPEMAP_HYDRATE && !(hydrate_plan = php_phongo_bson_hydrate_plan(state->map.root TSRMLS_CC))) {
+		goto cleanup;
+	}
+
+	/* Fields are only skipped while visiting if a projection was specified */
+	if (state->map.projection_map.children) {
+		state->projection = &state->map.projection_map;
+	}
+
 	/* We initialize an array because it will either be returned as-is (native
 	 * array in type map), passed to bsonUnserialize() (ODM class), or used to
-	 * initialize a stdClass object (native object in type map). */
+	 * initialize a stdClass object (native object in type map). On PHP 7, a
+	 * Hydratable object is initialized instead and its properties are written
+	 * while visiting. */
 #if PHP_VERSION_ID >= 70000
-	array_init(&state->zchild);
+	if (hydrate_plan) {
+		object_init_ex(&state->zchild, state->map.root);
+		state->hydrate_plan = hydrate_plan;
+		state->hydrate_ce   = state->map.root;
+	} else {
+		php_phongo_bson_array_init(&state->zchild, b, false, state->projection);
+	}
 #else
-	array_init(state->zchild);
+	php_phongo_bson_array_init(state->zchild, b, false, state->projection);
 #endif
 
-	if (bson_iter_visit_all(&iter, &php_bson_visitors, state) || iter.err_off) {
+	/* Matching of fieldPaths starts at the root of the trie. If no field paths
+	 * were specified, there is nothing to match while visiting. */
+	if (state->map.field_path_map.children) {
+		root_node                     = &state->map.field_path_map;
+		state->field_path_nodes       = &root_node;
+		state->field_path_nodes_count = 1;
+	}
+
+	if (php_phongo_bson_iter_visit_all(&iter, state) || iter.err_off) {
 		/* Iteration stopped prematurely due to corruption or a failed visitor.
 		 * While we free the reader, state->zchild should be left as-is, since
 		 * the calling code may want to zval_ptr_dtor() it. If an exception has
@@ -1183,7 +2759,7 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 			zval obj;
 
 			object_init_ex(&obj, state->odm ? state->odm : state->map.root);
-			zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, &state->zchild);
+			php_phongo_bson_unserialize(&obj, state->odm ? state->odm : state->map.root, &state->zchild TSRMLS_CC);
 			zval_ptr_dtor(&state->zchild);
 			ZVAL_COPY_VALUE(&state->zchild, &obj);
 #else  /* PHP_VERSION_ID >= 70000 */
@@ -1191,7 +2767,7 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 
 			MAKE_STD_ZVAL(obj);
 			object_init_ex(obj, state->odm ? state->odm : state->map.root);
-			zend_call_method_with_1_params(&obj, NULL, NULL, BSON_UNSERIALIZE_FUNC_NAME, NULL, state->zchild);
+			php_phongo_bson_unserialize(obj, state->odm ? state->odm : state->map.root, state->zchild TSRMLS_CC);
 			zval_ptr_dtor(&state->zchild);
 			state->zchild = obj;
 #endif /* PHP_VERSION_ID >= 70000 */
@@ -1199,6 +2775,20 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 			break;
 		}
 
+		case PHONGO_TYPEMAP_HYDRATE: {
+#if PHP_VERSION_ID < 70000
+			zval* obj = NULL;
+
+			MAKE_STD_ZVAL(obj);
+			object_init_ex(obj, state->map.root);
+			php_phongo_bson_hydrate_object(obj, state->map.root, hydrate_plan, state->zchild TSRMLS_CC);
+			zval_ptr_dtor(&state->zchild);
+			state->zchild = obj;
+#endif /* PHP_VERSION_ID < 70000 */
+
+			break;
+		}
+
 		case PHONGO_TYPEMAP_NATIVE_OBJECT:
 		default:
 #if PHP_VERSION_ID >= 70000
@@ -1208,6 +2798,7 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 #endif
 	}
 
+check_eof:
 	if (bson_reader_read(reader, &eof) || !eof) {
 		phongo_throw_exception(PHONGO_ERROR_UNEXPECTED_VALUE TSRMLS_CC, "Reading document did not exhaust input buffer");
 
@@ -1217,6 +2808,12 @@ bool php_phongo_bson_to_zval_ex(const unsigned char* data, int data_len, php_pho
 	retval = true;
 
 cleanup:
+	state->field_path_nodes       = NULL;
+	state->field_path_nodes_count = 0;
+	state->hydrate_plan           = NULL;
+	state->hydrate_ce             = NULL;
+	state->projection             = NULL;
+
 	if (reader) {
 		bson_reader_destroy(reader);
 	}
@@ -1232,12 +2829,22 @@ cleanup:
  * on success; otherwise, NULL is returned and an exception is thrown. */
 static zend_class_entry* php_phongo_bson_state_fetch_class(const char* classname, int classname_len, zend_class_entry* interface_ce TSRMLS_DC) /* {{{ */
 {
+	php_phongo_bson_class_t* entry = php_phongo_bson_class_cache_find(classname, classname_len TSRMLS_CC);
+	zend_class_entry*        found_ce;
+
+	if (entry && instanceof_function(entry->ce, interface_ce TSRMLS_CC)) {
+		return entry->ce;
+	}
+
+	/* Fall back to an uncached lookup in order to report the error */
 #if PHP_VERSION_ID >= 70000
-	zend_string*      zs_classname = zend_string_init(classname, classname_len, 0);
-	zend_class_entry* found_ce     = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
-	zend_string_release(zs_classname);
+	{
+		zend_string* zs_classname = zend_string_init(classname, classname_len, 0);
+		found_ce                  = zend_fetch_class(zs_classname, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
+		zend_string_release(zs_classname);
+	}
 #else
-	zend_class_entry* found_ce = zend_fetch_class(classname, classname_len, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
+	found_ce = zend_fetch_class(classname, classname_len, ZEND_FETCH_CLASS_AUTO | ZEND_FETCH_CLASS_SILENT TSRMLS_CC);
 #endif
 
 	if (!found_ce) {
@@ -1275,8 +2882,16 @@ static bool php_phongo_bson_state_parse_type(zval* options, const char* name, ph
 	} else if (!strcasecmp(classname, "stdclass") || !strcasecmp(classname, "object")) {
 		*type    = PHONGO_TYPEMAP_NATIVE_OBJECT;
 		*type_ce = NULL;
+	} else if (!strcasecmp(classname, "bson")) {
+		*type    = PHONGO_TYPEMAP_BSON;
+		*type_ce = NULL;
 	} else {
-		if ((*type_ce = php_phongo_bson_state_fetch_class(classname, classname_len, php_phongo_unserializable_ce TSRMLS_CC))) {
+		php_phongo_bson_class_t* entry = php_phongo_bson_class_cache_find(classname, classname_len TSRMLS_CC);
+
+		if (entry && instanceof_function(entry->ce, php_phongo_hydratable_ce TSRMLS_CC)) {
+			*type    = PHONGO_TYPEMAP_HYDRATE;
+			*type_ce = entry->ce;
+		} else if ((*type_ce = php_phongo_bson_state_fetch_class(classname, classname_len, php_phongo_unserializable_ce TSRMLS_CC))) {
 			*type = PHONGO_TYPEMAP_CLASS;
 		} else {
 			retval = false;
@@ -1291,44 +2906,174 @@ cleanup:
 	return retval;
 } /* }}} */
 
-static void field_path_map_element_set_info(php_phongo_field_path_map_element* element, php_phongo_bson_typemap_types type, zend_class_entry* ce)
+/* Parses the "vector" type map key, which controls whether vector binaries are
+ * decoded as arrays or left as Binary objects. */
+static bool php_phongo_bson_state_parse_vector(zval* options, php_phongo_bson_typemap* map TSRMLS_DC) /* {{{ */
 {
-	element->node_type = type;
-	element->node_ce   = ce;
-}
+	char*     value;
+	int       value_len;
+	zend_bool value_free = 0;
+	bool      retval     = true;
+
+	value = php_array_fetch_string(options, "vector", &value_len, &value_free);
+
+	if (!value_len) {
+		goto cleanup;
+	}
+
+	if (!strcasecmp(value, "array")) {
+		map->vector_as_array = true;
+	} else if (!strcasecmp(value, "binary")) {
+		map->vector_as_array = false;
+	} else {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected 'vector' type map value to be \"array\" or \"binary\", \"%s\" given", value);
+		retval = false;
+	}
+
+cleanup:
+	if (value_free) {
+		str_efree(value);
+	}
+
+	return retval;
+} /* }}} */
+
+/* Names accepted in the "types" type map key, indexed by
+ * php_phongo_bson_typemap_leaf_types */
+static const char* php_phongo_bson_leaf_type_names[] = { "object", "string", "binary", "int", "datetime" };
+
+#define PHONGO_BSON_LEAF_TYPE(type) (1 << (type))
 
-static void map_add_field_path_element(php_phongo_bson_typemap* map, php_phongo_field_path_map_element* element)
+/* Parses one entry of the "types" type map key. The allowed mask is a set of
+ * PHONGO_BSON_LEAF_TYPE() flags, and allowed_desc is used in the exception
+ * message if the value is not among them. */
+static bool php_phongo_bson_state_parse_leaf_type(zval* types, const char* name, php_phongo_bson_typemap_leaf_types* type, int allowed, const char* allowed_desc TSRMLS_DC) /* {{{ */
 {
-	/* Make sure we have allocated enough */
-	if (map->field_paths.allocated_size < map->field_paths.size + 1) {
-		map->field_paths.allocated_size += PHONGO_FIELD_PATH_EXPANSION;
-		map->field_paths.map = erealloc(map->field_paths.map, sizeof(php_phongo_field_path_map_element) * map->field_paths.allocated_size);
+	char*     value;
+	int       value_len;
+	zend_bool value_free = 0;
+	bool      retval     = true;
+	size_t    i;
+
+	value = php_array_fetch_string(types, name, &value_len, &value_free);
+
+	if (!value_len) {
+		goto cleanup;
 	}
 
-	map->field_paths.map[map->field_paths.size] = element;
-	map->field_paths.size++;
-}
+	for (i = 0; i < sizeof(php_phongo_bson_leaf_type_names) / sizeof(php_phongo_bson_leaf_type_names[0]); i++) {
+		if ((allowed & PHONGO_BSON_LEAF_TYPE(i)) && !strcasecmp(value, php_phongo_bson_leaf_type_names[i])) {
+			*type = (php_phongo_bson_typemap_leaf_types) i;
+			goto cleanup;
+		}
+	}
+
+	phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected 'types' type map value for \"%s\" to be %s, \"%s\" given", name, allowed_desc, value);
+	retval = false;
+
+cleanup:
+	if (value_free) {
+		str_efree(value);
+	}
+
+	return retval;
+} /* }}} */
 
-static php_phongo_field_path_map_element* field_path_map_element_alloc(void)
+/* Parses the "types" type map key, which selects native representations for
+ * leaf BSON types so that visitors can skip allocating BSON type objects */
+static bool php_phongo_bson_state_parse_types(zval* typemap, php_phongo_bson_typemap* map TSRMLS_DC) /* {{{ */
 {
-	php_phongo_field_path_map_element* tmp = ecalloc(1, sizeof(php_phongo_field_path_map_element));
+	zval* types;
 
-	tmp->entry = php_phongo_field_path_alloc(true);
+	if (!php_array_existsc(typemap, "types")) {
+		return true;
+	}
 
-	return tmp;
+	types = php_array_fetchc_array(typemap, "types");
+
+	if (!types) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "The 'types' element is not an array");
+		return false;
+	}
+
+	if (!php_phongo_bson_state_parse_leaf_type(
+			types, "objectId", &map->objectid_type,
+			PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_DEFAULT) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_STRING) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_BINARY),
+			"\"object\", \"string\", or \"binary\"" TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_leaf_type(
+			types, "utcDateTime", &map->utcdatetime_type,
+			PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_DEFAULT) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_INT) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_DATETIME),
+			"\"object\", \"int\", or \"datetime\"" TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_leaf_type(
+			types, "decimal128", &map->decimal128_type,
+			PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_DEFAULT) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_STRING),
+			"\"object\" or \"string\"" TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_leaf_type(
+			types, "int64", &map->int64_type,
+			PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_INT) | PHONGO_BSON_LEAF_TYPE(PHONGO_TYPEMAP_LEAF_STRING),
+			"\"int\" or \"string\"" TSRMLS_CC)) {
+		return false;
+	}
+
+	if (map->utcdatetime_type == PHONGO_TYPEMAP_LEAF_DATETIME && !php_phongo_date_immutable_ce) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Decoding \"utcDateTime\" as \"datetime\" requires DateTimeImmutable");
+		return false;
+	}
+
+	return true;
+} /* }}} */
+
+static php_phongo_field_path_node* field_path_node_find_or_add_child(php_phongo_field_path_node* parent, const char* name, size_t name_len)
+{
+	php_phongo_field_path_node* node;
+
+	for (node = parent->children; node; node = node->next) {
+		if (strlen(node->name) == name_len && strncmp(node->name, name, name_len) == 0) {
+			return node;
+		}
+	}
+
+	node            = ecalloc(1, sizeof(php_phongo_field_path_node));
+	node->name      = estrndup(name, name_len);
+	node->node_type = PHONGO_TYPEMAP_NONE;
+
+	/* Append, so that siblings are kept in insertion order */
+	if (!parent->children) {
+		parent->children = node;
+	} else {
+		php_phongo_field_path_node* last = parent->children;
+
+		while (last->next) {
+			last = last->next;
+		}
+		last->next = node;
+	}
+
+	return node;
 }
 
-static void field_path_map_element_dtor(php_phongo_field_path_map_element* element)
+static void field_path_node_free_children(php_phongo_field_path_node* node)
 {
-	php_phongo_field_path_free(element->entry);
-	efree(element);
+	php_phongo_field_path_node* child = node->children;
+
+	while (child) {
+		php_phongo_field_path_node* next = child->next;
+
+		field_path_node_free_children(child);
+		efree(child->name);
+		efree(child);
+
+		child = next;
+	}
+
+	node->children = NULL;
 }
 
 bool php_phongo_bson_state_add_field_path(php_phongo_bson_typemap* map, char* field_path_original, php_phongo_bson_typemap_types type, zend_class_entry* ce TSRMLS_DC)
 {
-	char*                              ptr         = NULL;
-	char*                              segment_end = NULL;
-	php_phongo_field_path_map_element* field_path_map_element;
+	char*                       ptr         = NULL;
+	char*                       segment_end = NULL;
+	php_phongo_field_path_node* node;
 
 	if (field_path_original[0] == '.') {
 		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "A 'fieldPaths' key may not start with a '.'");
@@ -1340,50 +3085,152 @@ bool php_phongo_bson_state_add_field_path(php_phongo_bson_typemap* map, char* fi
 		return false;
 	}
 
-	field_path_map_element = field_path_map_element_alloc();
-	ptr                    = field_path_original;
+	/* Bail out if we have an empty segment, before any nodes are added */
+	if (strstr(field_path_original, "..")) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "A 'fieldPaths' key may not have an empty segment");
+		return false;
+	}
+
+	node = &map->field_path_map;
+	ptr  = field_path_original;
 
 	/* Loop over all the segments. A segment is delimited by a "." */
 	while ((segment_end = strchr(ptr, '.')) != NULL) {
-		char* tmp = NULL;
-
-		/* Bail out if we have an empty segment */
-		if (ptr == segment_end) {
-			field_path_map_element_dtor(field_path_map_element);
-			phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "A 'fieldPaths' key may not have an empty segment");
-			return false;
-		}
-
-		tmp = calloc(1, segment_end - ptr + 1);
-		memcpy(tmp, ptr, segment_end - ptr);
-		php_phongo_field_path_push(field_path_map_element->entry, tmp, PHONGO_FIELD_PATH_ITEM_NONE);
-		free(tmp);
-
-		ptr = segment_end + 1;
+		node = field_path_node_find_or_add_child(node, ptr, segment_end - ptr);
+		ptr  = segment_end + 1;
 	}
 
 	/* Add the last (or single) element */
-	php_phongo_field_path_push(field_path_map_element->entry, ptr, PHONGO_FIELD_PATH_ITEM_NONE);
+	node = field_path_node_find_or_add_child(node, ptr, strlen(ptr));
 
-	field_path_map_element_set_info(field_path_map_element, type, ce);
-	map_add_field_path_element(map, field_path_map_element);
+	node->node_type = type;
+	node->node_ce   = ce;
+	node->order     = map->field_path_count++;
 
 	return true;
 }
 
 void php_phongo_bson_typemap_dtor(php_phongo_bson_typemap* map)
 {
-	size_t i;
+	field_path_node_free_children(&map->field_path_map);
+	map->field_path_count = 0;
+
+	field_path_node_free_children(&map->projection_map);
+}
+
+/* Adds a field path to the projection trie. Paths ending at a node keep its
+ * entire subtree, so the node's children are discarded and any longer paths
+ * through it are ignored. */
+static bool php_phongo_bson_state_add_projection(php_phongo_bson_typemap* map, const char* field_path TSRMLS_DC) /* {{{ */
+{
+	const char*                 ptr = field_path;
+	php_phongo_field_path_node* node;
+
+	if (field_path[0] == '\0') {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "A 'projection' field path may not be an empty string");
+		return false;
+	}
+
+	if (field_path[0] == '.' || field_path[strlen(field_path) - 1] == '.' || strstr(field_path, "..")) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "A 'projection' field path may not have an empty segment");
+		return false;
+	}
+
+	node = &map->projection_map;
+
+	while (true) {
+		const char*                 segment_end = strchr(ptr, '.');
+		size_t                      segment_len = segment_end ? (size_t)(segment_end - ptr) : strlen(ptr);
+		php_phongo_field_path_node* child;
+
+		for (child = node->children; child; child = child->next) {
+			if (strlen(child->name) == segment_len && strncmp(child->name, ptr, segment_len) == 0) {
+				break;
+			}
+		}
+
+		/* An existing leaf node already keeps everything below it */
+		if (child && !child->children) {
+			return true;
+		}
+
+		if (!child) {
+			child = field_path_node_find_or_add_child(node, ptr, segment_len);
+		}
 
-	if (map->field_paths.map) {
-		for (i = 0; i < map->field_paths.size; i++) {
-			field_path_map_element_dtor(map->field_paths.map[i]);
+		if (!segment_end) {
+			field_path_node_free_children(child);
+			return true;
 		}
-		efree(map->field_paths.map);
+
+		node = child;
+		ptr  = segment_end + 1;
 	}
+} /* }}} */
 
-	map->field_paths.map = NULL;
-}
+/* Parses the projection type map key, which lists the field paths to keep
+ * while decoding. All other fields are skipped without being decoded. */
+static bool php_phongo_bson_state_parse_projection(zval* typemap, php_phongo_bson_typemap* map TSRMLS_DC) /* {{{ */
+{
+	zval*      projection;
+	HashTable* ht_data;
+
+	if (!php_array_existsc(typemap, "projection")) {
+		return true;
+	}
+
+	projection = php_array_fetchc_array(typemap, "projection");
+
+	if (!projection) {
+		phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "The 'projection' element is not an array");
+		return false;
+	}
+
+	ht_data = HASH_OF(projection);
+
+#if PHP_VERSION_ID >= 70000
+	{
+		zval* field_path;
+
+		ZEND_HASH_FOREACH_VAL(ht_data, field_path)
+		{
+			ZVAL_DEREF(field_path);
+
+			if (Z_TYPE_P(field_path) != IS_STRING) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected 'projection' field paths to be strings, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(field_path));
+				return false;
+			}
+
+			if (!php_phongo_bson_state_add_projection(map, Z_STRVAL_P(field_path) TSRMLS_CC)) {
+				return false;
+			}
+		}
+		ZEND_HASH_FOREACH_END();
+	}
+#else
+	{
+		HashPosition pos;
+		zval**       field_path;
+
+		for (
+			zend_hash_internal_pointer_reset_ex(ht_data, &pos);
+			zend_hash_get_current_data_ex(ht_data, (void**) &field_path, &pos) == SUCCESS;
+			zend_hash_move_forward_ex(ht_data, &pos)) {
+
+			if (Z_TYPE_PP(field_path) != IS_STRING) {
+				phongo_throw_exception(PHONGO_ERROR_INVALID_ARGUMENT TSRMLS_CC, "Expected 'projection' field paths to be strings, %s given", PHONGO_ZVAL_CLASS_OR_TYPE_NAME_P(*field_path));
+				return false;
+			}
+
+			if (!php_phongo_bson_state_add_projection(map, Z_STRVAL_PP(field_path) TSRMLS_CC)) {
+				return false;
+			}
+		}
+	}
+#endif /* PHP_VERSION_ID >= 70000 */
+
+	return true;
+} /* }}} */
 
 /* Loops over each element in the fieldPaths array (if exists, and is an
  * array), and then checks whether each element is a valid type mapping */
@@ -1493,6 +3340,12 @@ static void print_node_info(php_phongo_field_path_node* ptr, int level)
 		case PHONGO_TYPEMAP_NATIVE_OBJECT:
 			printf(" stdClass\n");
 			break;
+		case PHONGO_TYPEMAP_BSON:
+			printf(" bson\n");
+			break;
+		case PHONGO_TYPEMAP_HYDRATE:
+			printf(" hydrate (%s)\n", ZSTR_VAL(ptr->node_ce->name));
+			break;
 	}
 }
 
@@ -1526,6 +3379,9 @@ bool php_phongo_bson_typemap_to_state(zval* typemap, php_phongo_bson_typemap* ma
 	if (!php_phongo_bson_state_parse_type(typemap, "array", &map->array_type, &map->array TSRMLS_CC) ||
 		!php_phongo_bson_state_parse_type(typemap, "document", &map->document_type, &map->document TSRMLS_CC) ||
 		!php_phongo_bson_state_parse_type(typemap, "root", &map->root_type, &map->root TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_vector(typemap, map TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_types(typemap, map TSRMLS_CC) ||
+		!php_phongo_bson_state_parse_projection(typemap, map TSRMLS_CC) ||
 		!php_phongo_bson_state_parse_fieldpaths(typemap, map TSRMLS_CC)) {
 
 		/* Exception should already have been thrown */
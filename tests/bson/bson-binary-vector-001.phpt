@@ -0,0 +1,72 @@
+--TEST--
+MongoDB\BSON\Binary::fromVector() and toArray()
+--FILE--
+<?php
+
+use MongoDB\BSON\Binary;
+
+$tests = [
+    [[1.5, -0.25, 3], Binary::VECTOR_FLOAT32],
+    [[-1, 2, 127], Binary::VECTOR_INT8],
+    [[1, 0, 1, 1, 0, 0, 0, 0, 1], Binary::VECTOR_PACKED_BIT],
+    [[], Binary::VECTOR_FLOAT32],
+];
+
+foreach ($tests as $test) {
+    list($vector, $dtype) = $test;
+
+    $binary = Binary::fromVector($vector, $dtype);
+    var_dump($binary->getType() === Binary::TYPE_VECTOR);
+    echo bin2hex($binary->getData()), "\n";
+    echo json_encode($binary->toArray()), "\n";
+}
+
+echo "\nFLOAT32 is the default dtype:\n";
+var_dump(Binary::fromVector([1.5]) == Binary::fromVector([1.5], Binary::VECTOR_FLOAT32));
+
+echo "\nElements keep their types:\n";
+var_dump(Binary::fromVector([2])->toArray());
+var_dump(Binary::fromVector([2], Binary::VECTOR_INT8)->toArray());
+
+echo "\nVectors survive a BSON round trip:\n";
+$document = MongoDB\BSON\toPHP(MongoDB\BSON\fromPHP(['v' => Binary::fromVector([0.5, 1])]));
+var_dump($document->v->toArray());
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+27000000c03f000080be00004040
+[1.5,-0.25,3]
+bool(true)
+0300ff027f
+[-1,2,127]
+bool(true)
+1007b080
+[1,0,1,1,0,0,0,0,1]
+bool(true)
+2700
+[]
+
+FLOAT32 is the default dtype:
+bool(true)
+
+Elements keep their types:
+array(1) {
+  [0]=>
+  float(2)
+}
+array(1) {
+  [0]=>
+  int(2)
+}
+
+Vectors survive a BSON round trip:
+array(2) {
+  [0]=>
+  float(0.5)
+  [1]=>
+  float(1)
+}
+===DONE===
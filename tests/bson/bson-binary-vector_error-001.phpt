@@ -0,0 +1,50 @@
+--TEST--
+MongoDB\BSON\Binary::fromVector() and toArray() errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+use MongoDB\BSON\Binary;
+
+echo throws(function() {
+    Binary::fromVector([1.0], 42);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() {
+    Binary::fromVector([1.0, '2'], Binary::VECTOR_FLOAT32);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() {
+    Binary::fromVector([1, 128], Binary::VECTOR_INT8);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() {
+    Binary::fromVector([1, 0, 2], Binary::VECTOR_PACKED_BIT);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() {
+    (new Binary('foo', Binary::TYPE_GENERIC))->toArray();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() {
+    (new Binary("\x27\x00\x00\x00\x80", Binary::TYPE_VECTOR))->toArray();
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected dtype to be VECTOR_INT8, VECTOR_FLOAT32, or VECTOR_PACKED_BIT, 42 given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 1 to be a number, string given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 1 to be an integer between -128 and 127
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected vector element 2 to be 0 or 1
+OK: Got MongoDB\Driver\Exception\LogicException
+Expected Binary of type 9 (vector), 0 given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Binary vector data is malformed or uses an unsupported dtype
+===DONE===
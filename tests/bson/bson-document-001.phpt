@@ -0,0 +1,54 @@
+--TEST--
+MongoDB\BSON\Document::get(), has(), getPath() and hasPath()
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$document = MongoDB\BSON\Document::fromPHP([
+    'x' => 1,
+    'y' => 'foo',
+    'a' => ['b' => ['c' => 3.5]],
+    'list' => [1, ['d' => 4]],
+]);
+
+var_dump($document->has('x'));
+var_dump($document->has('z'));
+var_dump($document->get('x'));
+var_dump($document->get('y'));
+
+$a = $document->get('a');
+var_dump($a instanceof MongoDB\BSON\Document);
+var_dump($a->get('b')->get('c'));
+
+var_dump($document->hasPath('a.b.c'));
+var_dump($document->hasPath('a.b.z'));
+var_dump($document->getPath('a.b.c'));
+var_dump($document->getPath('list.1.d'));
+
+$list = $document->get('list');
+var_dump($list[0]);
+var_dump($list[1] instanceof MongoDB\BSON\Document);
+
+var_dump((string) $document === fromPHP($document->toPHP()));
+var_dump(toPHP(fromPHP(['doc' => $document]))->doc->a->b->c);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(false)
+int(1)
+string(3) "foo"
+bool(true)
+float(3.5)
+bool(true)
+bool(false)
+float(3.5)
+int(4)
+int(1)
+bool(true)
+bool(true)
+float(3.5)
+===DONE===
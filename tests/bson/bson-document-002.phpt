@@ -0,0 +1,43 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding to MongoDB\BSON\Document with the "bson" type map
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP(['_id' => 1, 'x' => ['y' => 2], 'z' => [['w' => 3]]]);
+
+$root = toPHP($bson, ['root' => 'bson']);
+var_dump($root instanceof MongoDB\BSON\Document);
+var_dump((string) $root === $bson);
+
+$value = toPHP($bson, ['document' => 'bson']);
+var_dump($value->x instanceof MongoDB\BSON\Document);
+var_dump($value->x->get('y'));
+var_dump($value->z[0] instanceof MongoDB\BSON\Document);
+
+$value = toPHP($bson, ['fieldPaths' => ['x' => 'bson']]);
+var_dump($value->x instanceof MongoDB\BSON\Document);
+var_dump($value->z[0] instanceof stdClass);
+
+$value = toPHP($bson, ['fieldPaths' => ['z' => 'bson']]);
+var_dump($value->z instanceof MongoDB\BSON\Document);
+var_dump($value->z->getPath('0.w'));
+
+var_dump(fromPHP($root) === $bson);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+int(2)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+int(3)
+bool(true)
+===DONE===
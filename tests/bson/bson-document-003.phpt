@@ -0,0 +1,33 @@
+--TEST--
+MongoDB\BSON\Document without BSON data behaves as an empty document
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+/* Cloning does not copy the BSON data, which leaves the same state as a failed
+ * unserialize() call. */
+$document = clone MongoDB\BSON\Document::fromPHP(['x' => 1]);
+
+var_dump($document->has('x'));
+var_dump($document->hasPath('x'));
+var_dump($document->toPHP());
+var_dump((string) $document === fromPHP([]));
+var_dump(unserialize(serialize($document))->toPHP());
+echo toJSON(fromPHP(['d' => $document])), "\n";
+echo toJSON(fromPHP($document)), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+bool(false)
+bool(false)
+object(stdClass)#%d (0) {
+}
+bool(true)
+object(stdClass)#%d (0) {
+}
+{ "d" : {  } }
+{ }
+===DONE===
@@ -0,0 +1,38 @@
+--TEST--
+MongoDB\BSON\Document errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$document = MongoDB\BSON\Document::fromPHP(['x' => ['y' => 1]]);
+
+echo throws(function() use ($document) {
+    $document->get('foo');
+}, 'MongoDB\Driver\Exception\RuntimeException'), "\n";
+
+echo throws(function() use ($document) {
+    $document->getPath('x.z');
+}, 'MongoDB\Driver\Exception\RuntimeException'), "\n";
+
+echo throws(function() {
+    MongoDB\BSON\Document::fromBSON('foo');
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+echo throws(function() {
+    MongoDB\BSON\Document::fromBSON(fromPHP(['x' => 1]) . fromPHP(['y' => 1]));
+}, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not find key "foo" in BSON document
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Could not find path "x.z" in BSON document
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Could not read document from BSON reader
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Reading document did not exhaust input buffer
+===DONE===
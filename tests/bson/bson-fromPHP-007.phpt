@@ -0,0 +1,70 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Encoding repeated instances of the same classes
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+class PublicOnly {
+    public $a = 1;
+}
+
+class WithHidden {
+    private $hidden = 'private';
+    protected $shielded = 'protected';
+    public $b = 2;
+}
+
+/* Inherits a private property without declaring any of its own */
+class InheritsHidden extends WithHidden {}
+
+class MyPersistable implements MongoDB\BSON\Persistable {
+    public $c = 3;
+
+    public function bsonSerialize()
+    {
+        return ['c' => $this->c];
+    }
+
+    public function bsonUnserialize(array $data)
+    {
+    }
+}
+
+$oid = new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b1');
+
+foreach ([1, 2] as $i) {
+    $dynamic = new PublicOnly;
+    $dynamic->d = $i;
+
+    echo toJSON(fromPHP([
+        'public' => new PublicOnly,
+        'dynamic' => $dynamic,
+        'hidden' => new WithHidden,
+        'inherited' => new InheritsHidden,
+        'stdClass' => (object) ['e' => $i],
+        'persistable' => new MyPersistable,
+        'oid' => $oid,
+        'date' => new MongoDB\BSON\UTCDateTime('1416445411987'),
+    ])), "\n";
+
+    echo toJSON(fromPHP(new InheritsHidden)), "\n";
+}
+
+/* Per PHPC-884, keys with a leading null byte are skipped for any object's
+ * properties, including stdClass and classes with only public properties */
+$public = new PublicOnly;
+$public->{"\0"} = 1;
+
+echo toJSON(fromPHP((object) ["\0" => 1, 'nested' => (object) ["\0" => 1, 'f' => 1], 'public' => $public])), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{ "public" : { "a" : 1 }, "dynamic" : { "a" : 1, "d" : 1 }, "hidden" : { "b" : 2 }, "inherited" : { "b" : 2 }, "stdClass" : { "e" : 1 }, "persistable" : { "__pclass" : { "$binary" : "TXlQZXJzaXN0YWJsZQ==", "$type" : "80" }, "c" : 3 }, "oid" : { "$oid" : "56315a7c6118fd1b920270b1" }, "date" : { "$date" : 1416445411987 } }
+{ "b" : 2 }
+{ "public" : { "a" : 1 }, "dynamic" : { "a" : 1, "d" : 2 }, "hidden" : { "b" : 2 }, "inherited" : { "b" : 2 }, "stdClass" : { "e" : 2 }, "persistable" : { "__pclass" : { "$binary" : "TXlQZXJzaXN0YWJsZQ==", "$type" : "80" }, "c" : 3 }, "oid" : { "$oid" : "56315a7c6118fd1b920270b1" }, "date" : { "$date" : 1416445411987 } }
+{ "b" : 2 }
+{ "nested" : { "f" : 1 }, "public" : { "a" : 1 } }
+===DONE===
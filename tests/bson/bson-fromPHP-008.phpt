@@ -0,0 +1,48 @@
+--TEST--
+MongoDB\BSON\fromPHP(): Detection of PHP arrays that are encoded as BSON arrays
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$withHole = [1, 2, 3];
+unset($withHole[1]);
+
+$withoutLast = [1, 2, 3];
+unset($withoutLast[2]);
+
+$sparse = [];
+$sparse[2] = 'c';
+
+$reordered = [1 => 'b', 0 => 'a'];
+
+$large = range(0, 1200);
+
+$tests = [
+    'list' => [1, 2, 3],
+    'withHole' => $withHole,
+    'withoutLast' => $withoutLast,
+    'sparse' => $sparse,
+    'reordered' => $reordered,
+    'nested' => [[1, 2], ['x' => 1]],
+];
+
+foreach ($tests as $name => $value) {
+    echo $name, ': ', toJSON(fromPHP(['x' => $value])), "\n";
+}
+
+$document = toPHP(fromPHP(['x' => $large]), ['array' => 'array']);
+var_dump($document->x === $large);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+list: { "x" : [ 1, 2, 3 ] }
+withHole: { "x" : { "0" : 1, "2" : 3 } }
+withoutLast: { "x" : [ 1, 2 ] }
+sparse: { "x" : { "2" : "c" } }
+reordered: { "x" : { "1" : "b", "0" : "a" } }
+nested: { "x" : [ [ 1, 2 ], { "x" : 1 } ] }
+bool(true)
+===DONE===
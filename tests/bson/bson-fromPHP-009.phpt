@@ -0,0 +1,45 @@
+--TEST--
+MongoDB\BSON\fromPHP(): UTF-8 validation accepts valid strings
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$ascii = str_repeat('abcdefgh', 5);
+
+$tests = [
+    'ascii' => $ascii,
+    'embedded NUL' => "a\0b",
+    'two-byte NUL' => "\xc0\x80",
+    'two-byte' => $ascii . "\xc3\xa9" . $ascii,
+    'three-byte' => "\xe2\x82\xac",
+    'four-byte' => $ascii . "\xf0\x9f\x98\x80",
+    'max code point' => "\xf4\x8f\xbf\xbf",
+];
+
+foreach ($tests as $name => $string) {
+    echo $name, ': ';
+    var_dump(toPHP(fromPHP(['x' => $string]))->x === $string);
+}
+
+/* BSON permits the overlong two-byte NUL, but encoding such a string must not
+ * mark it as valid UTF-8 for other extensions (e.g. PCRE) */
+$overlong = str_repeat("\xc0\x80", 2);
+fromPHP(['x' => $overlong]);
+var_dump(preg_match('/^..$/u', $overlong));
+var_dump(preg_last_error() === PREG_BAD_UTF8_ERROR);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+ascii: bool(true)
+embedded NUL: bool(true)
+two-byte NUL: bool(true)
+two-byte: bool(true)
+three-byte: bool(true)
+four-byte: bool(true)
+max code point: bool(true)
+bool(false)
+bool(true)
+===DONE===
@@ -0,0 +1,67 @@
+--TEST--
+MongoDB\BSON\fromPHP(): UTF-8 validation rejects invalid strings
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$ascii = str_repeat('abcdefgh', 5);
+
+$tests = [
+    'invalid lead byte after ASCII run' => $ascii . "\xff",
+    'unexpected continuation byte' => "\x80",
+    'truncated sequence' => $ascii . "\xe2\x82",
+    'invalid continuation byte' => "\xe2\x28\xa1",
+    'overlong two-byte' => "\xc1\xbf",
+    'overlong three-byte' => "\xe0\x9f\xbf",
+    'overlong four-byte' => "\xf0\x8f\xbf\xbf",
+    'surrogate' => "\xed\xa0\x80",
+    'beyond U+10FFFF' => "\xf4\x90\x80\x80",
+];
+
+foreach ($tests as $name => $string) {
+    echo $name, ': ';
+
+    echo throws(function() use ($string) {
+        fromPHP(['x' => $string]);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+echo "\nStrings are validated each time they are encoded:\n";
+$string = $ascii . "\xff";
+
+for ($i = 0; $i < 2; $i++) {
+    echo throws(function() use ($string) {
+        fromPHP(['x' => $string]);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+invalid lead byte after ASCII run: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+unexpected continuation byte: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+truncated sequence: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+invalid continuation byte: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+overlong two-byte: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+overlong three-byte: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+overlong four-byte: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+surrogate: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+beyond U+10FFFF: OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+
+Strings are validated each time they are encoded:
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected invalid UTF-8 for field path "x": %s
+===DONE===
@@ -0,0 +1,46 @@
+--TEST--
+MongoDB\BSON\toPHP(): fieldPaths with overlapping wildcard and named segments
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP([
+    'a' => ['b' => ['x' => 1], 'c' => ['x' => 2]],
+    'd' => ['b' => ['x' => 3]],
+]);
+
+echo "Wildcard registered first\n";
+$value = toPHP($bson, ['fieldPaths' => [
+    '$.b' => 'array',
+    'a.b' => 'object',
+    'a' => 'array',
+]]);
+var_dump(is_array($value->a));
+var_dump(is_array($value->a['b']));
+var_dump($value->a['c'] instanceof stdClass);
+var_dump(is_array($value->d->b));
+
+echo "\nNamed path registered first\n";
+$value = toPHP($bson, ['fieldPaths' => [
+    'a.b' => 'object',
+    '$.b' => 'array',
+    'a.$.x' => 'array',
+]]);
+var_dump($value->a->b instanceof stdClass);
+var_dump(is_array($value->d->b));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Wildcard registered first
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+
+Named path registered first
+bool(true)
+bool(true)
+===DONE===
@@ -0,0 +1,107 @@
+--TEST--
+MongoDB\BSON\toPHP(): Hydratable classes are populated according to their field map
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+class User implements MongoDB\BSON\Hydratable
+{
+    private $id;
+    protected $name;
+    public $address;
+
+    public function __construct()
+    {
+        echo "Constructor should not be called\n";
+    }
+
+    public static function bsonFieldMap()
+    {
+        return ['_id' => 'id', 'n' => 'name', 'addr' => 'address', 'x' => 'extra'];
+    }
+}
+
+class Address implements MongoDB\BSON\Hydratable
+{
+    public $street;
+    public $city;
+    public static $ignored = 'static';
+
+    public static function bsonFieldMap()
+    {
+        return null;
+    }
+}
+
+$bson = fromPHP([
+    '_id' => 1,
+    'n' => 'alice',
+    'unmapped' => ['a' => 1],
+    'addr' => ['city' => 'Berlin', 'street' => 'Main', 'zip' => '10115', 'ignored' => 'x'],
+    'x' => [1, 2],
+]);
+
+var_dump(toPHP($bson, ['root' => 'User', 'fieldPaths' => ['addr' => 'Address']]));
+
+echo "\nArrays are hydrated using element indexes as field names\n";
+var_dump(toPHP(fromPHP(['addr' => ['Main', 'Berlin']]), ['array' => 'Address']));
+
+class Pair implements MongoDB\BSON\Hydratable
+{
+    public $first;
+    public $second;
+
+    public static function bsonFieldMap()
+    {
+        return ['0' => 'first', '1' => 'second'];
+    }
+}
+
+var_dump(toPHP(fromPHP(['pair' => ['a', 'b', 'c']]), ['array' => 'Pair']));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+object(User)#%d (4) {
+  ["id":"User":private]=>
+  int(1)
+  ["name":protected]=>
+  string(5) "alice"
+  ["address"]=>
+  object(Address)#%d (2) {
+    ["street"]=>
+    string(4) "Main"
+    ["city"]=>
+    string(6) "Berlin"
+  }
+  ["extra"]=>
+  array(2) {
+    [0]=>
+    int(1)
+    [1]=>
+    int(2)
+  }
+}
+
+Arrays are hydrated using element indexes as field names
+object(stdClass)#%d (1) {
+  ["addr"]=>
+  object(Address)#%d (2) {
+    ["street"]=>
+    NULL
+    ["city"]=>
+    NULL
+  }
+}
+object(stdClass)#%d (1) {
+  ["pair"]=>
+  object(Pair)#%d (2) {
+    ["first"]=>
+    string(1) "a"
+    ["second"]=>
+    string(1) "b"
+  }
+}
+===DONE===
@@ -0,0 +1,58 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding arrays of numbers
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$tests = [
+    'doubles' => [1.5, 2.5, -1.0],
+    'ints' => [1, -2, 2147483647],
+    'mixed' => [1, 2.5, 3],
+    'withString' => [1, '2', 3.0],
+    'nested' => [[1, 2], [3.5]],
+    'empty' => [],
+];
+
+foreach ($tests as $name => $value) {
+    $document = toPHP(fromPHP(['x' => $value]), ['root' => 'array']);
+    echo $name, ': ';
+    var_dump($document['x'] === $value);
+}
+
+echo "\nType map is applied:\n";
+$document = toPHP(fromPHP(['x' => [1, 2.5]]), ['array' => 'object']);
+var_dump($document->x instanceof stdClass);
+var_dump($document->x == (object) [1, 2.5]);
+
+echo "\nElements keep their types:\n";
+var_dump(toPHP(fromPHP(['x' => [1, 2.5, 3.0]]), ['root' => 'array']));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+doubles: bool(true)
+ints: bool(true)
+mixed: bool(true)
+withString: bool(true)
+nested: bool(true)
+empty: bool(true)
+
+Type map is applied:
+bool(true)
+bool(true)
+
+Elements keep their types:
+array(1) {
+  ["x"]=>
+  array(3) {
+    [0]=>
+    int(1)
+    [1]=>
+    float(2.5)
+    [2]=>
+    float(3)
+  }
+}
+===DONE===
@@ -0,0 +1,65 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding vector binaries as arrays with the "vector" type map key
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+use MongoDB\BSON\Binary;
+
+$bson = fromPHP([
+    'float32' => Binary::fromVector([1.5, -2]),
+    'int8' => Binary::fromVector([-3, 4], Binary::VECTOR_INT8),
+    'malformed' => new Binary("\x27\x00\x00", Binary::TYPE_VECTOR),
+    'generic' => new Binary('foo', Binary::TYPE_GENERIC),
+    'nested' => [Binary::fromVector([0.5])],
+]);
+
+$document = toPHP($bson, ['root' => 'array', 'vector' => 'array']);
+var_dump($document['float32'], $document['int8'], $document['nested']);
+var_dump($document['malformed'] instanceof Binary);
+var_dump($document['generic'] instanceof Binary);
+
+echo "\nVectors are left as Binary objects by default:\n";
+$document = toPHP($bson, ['root' => 'array']);
+var_dump($document['float32'] instanceof Binary);
+$document = toPHP($bson, ['root' => 'array', 'vector' => 'binary']);
+var_dump($document['float32'] instanceof Binary);
+
+echo "\n", throws(function() use ($bson) {
+    toPHP($bson, ['vector' => 'object']);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array(2) {
+  [0]=>
+  float(1.5)
+  [1]=>
+  float(-2)
+}
+array(2) {
+  [0]=>
+  int(-3)
+  [1]=>
+  int(4)
+}
+array(1) {
+  [0]=>
+  array(1) {
+    [0]=>
+    float(0.5)
+  }
+}
+bool(true)
+bool(true)
+
+Vectors are left as Binary objects by default:
+bool(true)
+bool(true)
+
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'vector' type map value to be "array" or "binary", "object" given
+===DONE===
@@ -0,0 +1,83 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding leaf types with the "types" type map key
+--SKIPIF--
+<?php if (8 !== PHP_INT_SIZE) { die('skip Only for 64-bit platform'); } ?>
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP([
+    'oid' => new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b1'),
+    'date' => new MongoDB\BSON\UTCDateTime(1416445411987),
+    'decimal' => new MongoDB\BSON\Decimal128('1234.5678'),
+    'int64' => PHP_INT_MAX,
+    'list' => [new MongoDB\BSON\ObjectId('56315a7c6118fd1b920270b1')],
+    'numbers' => [1, PHP_INT_MAX, 2.5],
+]);
+
+echo "Scalars:\n";
+var_dump(toPHP($bson, ['root' => 'array', 'types' => [
+    'objectId' => 'string',
+    'utcDateTime' => 'int',
+    'decimal128' => 'string',
+    'int64' => 'string',
+]]));
+
+echo "\nObjectId as binary:\n";
+$document = toPHP($bson, ['types' => ['objectId' => 'binary']]);
+var_dump(bin2hex($document->oid));
+
+echo "\nUTCDateTime as DateTimeImmutable:\n";
+$document = toPHP($bson, ['types' => ['utcDateTime' => 'datetime']]);
+var_dump(get_class($document->date));
+var_dump($document->date->format('Y-m-d H:i:s'));
+
+echo "\nDefaults decode BSON type objects:\n";
+$document = toPHP($bson, ['types' => ['objectId' => 'object', 'utcDateTime' => 'object', 'decimal128' => 'object']]);
+var_dump($document->oid instanceof MongoDB\BSON\ObjectId);
+var_dump($document->date instanceof MongoDB\BSON\UTCDateTime);
+var_dump($document->decimal instanceof MongoDB\BSON\Decimal128);
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Scalars:
+array(6) {
+  ["oid"]=>
+  string(24) "56315a7c6118fd1b920270b1"
+  ["date"]=>
+  int(1416445411987)
+  ["decimal"]=>
+  string(9) "1234.5678"
+  ["int64"]=>
+  string(19) "9223372036854775807"
+  ["list"]=>
+  array(1) {
+    [0]=>
+    string(24) "56315a7c6118fd1b920270b1"
+  }
+  ["numbers"]=>
+  array(3) {
+    [0]=>
+    int(1)
+    [1]=>
+    string(19) "9223372036854775807"
+    [2]=>
+    float(2.5)
+  }
+}
+
+ObjectId as binary:
+string(24) "56315a7c6118fd1b920270b1"
+
+UTCDateTime as DateTimeImmutable:
+string(17) "DateTimeImmutable"
+string(19) "2014-11-20 01:03:31"
+
+Defaults decode BSON type objects:
+bool(true)
+bool(true)
+bool(true)
+===DONE===
@@ -0,0 +1,55 @@
+--TEST--
+MongoDB\BSON\toPHP(): Skipping fields with the "projection" type map key
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP([
+    '_id' => 1,
+    'name' => 'foo',
+    'address' => ['city' => 'Berlin', 'zip' => '10115', 'geo' => ['lat' => 52.5, 'lng' => 13.4]],
+    'tags' => ['a', 'b'],
+    'items' => [['sku' => 'x', 'qty' => 1], ['sku' => 'y', 'qty' => 2], 42],
+    'scores' => [1, 2, 3],
+]);
+
+$typemaps = [
+    ['projection' => ['name', 'tags']],
+    ['projection' => ['address.city', 'address.geo.lat']],
+    ['projection' => ['address.city', 'address']],
+    ['projection' => ['address', 'address.city']],
+    ['projection' => ['items.sku', 'scores']],
+    ['projection' => ['missing']],
+    ['projection' => []],
+];
+
+foreach ($typemaps as $typemap) {
+    echo json_encode($typemap['projection']), ': ';
+    echo json_encode(toPHP($bson, $typemap + ['root' => 'array'])), "\n";
+}
+
+echo "\nProjection applies to embedded documents decoded as objects:\n";
+var_dump(toPHP($bson, ['projection' => ['address.zip']]));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+["name","tags"]: {"name":"foo","tags":["a","b"]}
+["address.city","address.geo.lat"]: {"address":{"city":"Berlin","geo":{"lat":52.5}}}
+["address.city","address"]: {"address":{"city":"Berlin","zip":"10115","geo":{"lat":52.5,"lng":13.4}}}
+["address","address.city"]: {"address":{"city":"Berlin","zip":"10115","geo":{"lat":52.5,"lng":13.4}}}
+["items.sku","scores"]: {"items":[{"sku":"x"},{"sku":"y"}],"scores":[1,2,3]}
+["missing"]: []
+[]: {"_id":1,"name":"foo","address":{"city":"Berlin","zip":"10115","geo":{"lat":52.5,"lng":13.4}},"tags":["a","b"],"items":[{"sku":"x","qty":1},{"sku":"y","qty":2},42],"scores":[1,2,3]}
+
+Projection applies to embedded documents decoded as objects:
+object(stdClass)#%d (1) {
+  ["address"]=>
+  object(stdClass)#%d (1) {
+    ["zip"]=>
+    string(5) "10115"
+  }
+}
+===DONE===
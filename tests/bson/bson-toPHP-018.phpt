@@ -0,0 +1,39 @@
+--TEST--
+MongoDB\BSON\toPHP(): Decoding wide documents and arrays
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$document = [];
+$list = [];
+
+for ($i = 0; $i < 1000; $i++) {
+    $document['field' . $i] = $i;
+    $list[] = 'value' . $i;
+}
+
+$value = ['document' => $document, 'list' => $list, 'empty' => [], 'emptyDocument' => (object) []];
+
+var_dump(toPHP(fromPHP($value), ['root' => 'array', 'document' => 'array']) === ['document' => $document, 'list' => $list, 'empty' => [], 'emptyDocument' => []]);
+
+$decoded = toPHP(fromPHP($value));
+var_dump(count((array) $decoded->document));
+var_dump(count($decoded->list));
+var_dump($decoded->list[999]);
+
+$decoded->list[] = 'appended';
+var_dump(count($decoded->list));
+var_dump(array_keys($decoded->list) === range(0, 1000));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+int(1000)
+int(1000)
+string(8) "value999"
+int(1001)
+bool(true)
+===DONE===
@@ -0,0 +1,36 @@
+--TEST--
+MongoDB\BSON\toPHP(): Hydratable classes receive 64-bit integers on 32-bit platforms
+--SKIPIF--
+<?php if (4 !== PHP_INT_SIZE) { die('skip Only for 32-bit platform'); } ?>
+--FILE--
+<?php
+
+class Counter implements MongoDB\BSON\Hydratable
+{
+    public $small;
+    public $large;
+
+    public static function bsonFieldMap()
+    {
+        return null;
+    }
+}
+
+$bson = MongoDB\BSON\fromJSON('{"small": {"$numberLong": "42"}, "large": {"$numberLong": "9223372036854775807"}}');
+
+var_dump(MongoDB\BSON\toPHP($bson, ['root' => 'Counter']));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+object(Counter)#%d (%d) {
+  ["small"]=>
+  int(42)
+  ["large"]=>
+  object(MongoDB\BSON\Int64)#%d (%d) {
+    ["integer"]=>
+    string(19) "9223372036854775807"
+  }
+}
+===DONE===
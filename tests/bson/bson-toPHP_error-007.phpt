@@ -0,0 +1,40 @@
+--TEST--
+MongoDB\BSON\toPHP(): Hydratable::bsonFieldMap() must return an array of strings or null
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+class MyHydratable implements MongoDB\BSON\Hydratable
+{
+    public static $map;
+
+    public static function bsonFieldMap()
+    {
+        return self::$map;
+    }
+}
+
+$bson = fromPHP(['a' => 1]);
+
+foreach ([true, 'string', ['a' => null], [0 => 1]] as $map) {
+    MyHydratable::$map = $map;
+
+    echo throws(function() use ($bson) {
+        toPHP($bson, ['root' => 'MyHydratable']);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Expected MyHydratable::bsonFieldMap() to return an array or null, boolean given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Expected MyHydratable::bsonFieldMap() to return an array or null, string given
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Expected MyHydratable::bsonFieldMap() to return an array mapping field names to property names
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Expected MyHydratable::bsonFieldMap() to return an array mapping field names to property names
+===DONE===
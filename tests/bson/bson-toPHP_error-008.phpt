@@ -0,0 +1,38 @@
+--TEST--
+MongoDB\BSON\toPHP(): "types" type map key errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP(['x' => 1]);
+
+$typemaps = [
+    ['types' => 'string'],
+    ['types' => ['objectId' => 'int']],
+    ['types' => ['utcDateTime' => 'string']],
+    ['types' => ['decimal128' => 'binary']],
+    ['types' => ['int64' => 'object']],
+];
+
+foreach ($typemaps as $typemap) {
+    echo throws(function() use ($bson, $typemap) {
+        toPHP($bson, $typemap);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'types' element is not an array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'types' type map value for "objectId" to be "object", "string", or "binary", "int" given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'types' type map value for "utcDateTime" to be "object", "int", or "datetime", "string" given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'types' type map value for "decimal128" to be "object" or "string", "binary" given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'types' type map value for "int64" to be "int" or "string", "object" given
+===DONE===
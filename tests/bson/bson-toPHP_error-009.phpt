@@ -0,0 +1,41 @@
+--TEST--
+MongoDB\BSON\toPHP(): "projection" type map key errors
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$bson = fromPHP(['x' => 1]);
+
+$projections = [
+    'x',
+    [1],
+    [''],
+    ['.x'],
+    ['x.'],
+    ['x..y'],
+];
+
+foreach ($projections as $projection) {
+    echo throws(function() use ($bson, $projection) {
+        toPHP($bson, ['projection' => $projection]);
+    }, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The 'projection' element is not an array
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected 'projection' field paths to be strings, integer given
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+A 'projection' field path may not be an empty string
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+A 'projection' field path may not have an empty segment
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+A 'projection' field path may not have an empty segment
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+A 'projection' field path may not have an empty segment
+===DONE===
@@ -0,0 +1,57 @@
+--TEST--
+MongoDB\BSON\toPHP(): UTF-8 validation of keys and strings when decoding
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+$ascii = str_repeat('abcdefgh', 5);
+
+$tests = [
+    // Invalid UTF-8 after a run of ASCII in a string
+    str_replace('INVALID!', "INVALID\xFE", fromPHP(['x' => $ascii . 'INVALID!'])),
+    // Truncated multi-byte sequence at the end of a string
+    str_replace('INVALID!', "INVALID\xE2", fromPHP(['x' => $ascii . 'INVALID!'])),
+    // Surrogate within a string
+    str_replace('INVALID!', "INVA\xED\xA0\x80!", fromPHP(['x' => $ascii . 'INVALID!'])),
+    // Two-byte encoding of NUL in a field name
+    str_replace('INVALID!', "INVALI\xC0\x80", fromPHP([$ascii . 'INVALID!' => 1])),
+    // Invalid UTF-8 in JavaScript code
+    str_replace('INVALID!', "INVALID\xFE", fromPHP(['x' => new MongoDB\BSON\Javascript($ascii . 'INVALID!')])),
+    // Invalid UTF-8 in a regular expression pattern
+    str_replace('INVALID!', "INVALID\xFE", fromPHP(['x' => new MongoDB\BSON\Regex($ascii . 'INVALID!')])),
+    // Invalid UTF-8 in a symbol
+    str_replace('INVALID!', "INVALID\xFE", fromJSON('{"x": {"$symbol": "' . $ascii . 'INVALID!"}}')),
+];
+
+foreach ($tests as $bson) {
+    echo throws(function() use ($bson) {
+        toPHP($bson);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+echo "\nThe two-byte encoding of NUL is accepted in strings:\n";
+var_dump(toPHP(fromPHP(['x' => $ascii . "\xC0\x80"]))->x === $ascii . "\xC0\x80");
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+
+The two-byte encoding of NUL is accepted in strings:
+bool(true)
+===DONE===
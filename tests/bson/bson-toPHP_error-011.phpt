@@ -0,0 +1,70 @@
+--TEST--
+MongoDB\BSON\toPHP(): Invalid UTF-8 in each BSON type with string data
+--FILE--
+<?php
+
+require_once __DIR__ . '/../utils/tools.php';
+
+/* Each document holds a single field whose string data (or key) contains the
+ * only "b" byte. The invalid documents replace it with 0xE9, which is not valid
+ * UTF-8 on its own. */
+$tests = [
+    'String' => '0E00000002610002000000620000',
+    'Regex pattern' => '0B0000000B610062000000',
+    'Regex options' => '0C0000000B61006100620000',
+    'DBPointer' => '1A0000000C610002000000620056E1FC72E0C917E9C471416100',
+    'Code' => '0E0000000D610002000000620000',
+    'Symbol' => '0E0000000E610002000000620000',
+    'Code with scope' => '170000000F61000F000000020000006200050000000000',
+    'Key' => '0C0000001062000100000000',
+];
+
+foreach ($tests as $name => $hex) {
+    echo $name, ":\n";
+
+    var_dump(toPHP(hex2bin($hex)) instanceof stdClass);
+
+    $bson = str_replace('b', "\xE9", hex2bin($hex));
+
+    echo throws(function() use ($bson) {
+        toPHP($bson);
+    }, 'MongoDB\Driver\Exception\UnexpectedValueException'), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+String:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Regex pattern:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Regex options:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+DBPointer:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Code:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Symbol:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Code with scope:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+Key:
+bool(true)
+OK: Got MongoDB\Driver\Exception\UnexpectedValueException
+Detected corrupt BSON data for field path '%S' at offset %d
+===DONE===
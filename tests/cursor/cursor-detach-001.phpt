@@ -0,0 +1,83 @@
+--TEST--
+MongoDB\Driver\Cursor::detach() allows a cursor to be attached after it is freed
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+class CommandLogger implements MongoDB\Driver\Monitoring\CommandSubscriber
+{
+    public function commandStarted(MongoDB\Driver\Monitoring\CommandStartedEvent $event)
+    {
+        printf("Executing %s\n", $event->getCommandName());
+    }
+
+    public function commandSucceeded(MongoDB\Driver\Monitoring\CommandSucceededEvent $event)
+    {
+    }
+
+    public function commandFailed(MongoDB\Driver\Monitoring\CommandFailedEvent $event)
+    {
+    }
+}
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+MongoDB\Driver\Monitoring\addSubscriber(new CommandLogger);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+
+foreach ($cursor as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+
+    if ($key === 1) {
+        break;
+    }
+}
+
+$token = $cursor->detach();
+var_dump($token === $cursor->detach());
+
+/* The server cursor is retained once the Cursor is freed */
+unset($cursor);
+
+echo "\nAttached:\n";
+$cursor = $manager->attachCursor($token);
+
+foreach ($cursor as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+}
+
+echo throws(function() use ($manager, $token) {
+    $manager->attachCursor($token);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+Executing find
+0 => {"_id":0}
+1 => {"_id":1}
+bool(true)
+
+Attached:
+Executing getMore
+0 => {"_id":2}
+1 => {"_id":3}
+Executing getMore
+2 => {"_id":4}
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+No detached cursor exists for token "%s"
+===DONE===
@@ -0,0 +1,59 @@
+--TEST--
+MongoDB\Driver\Cursor::detach() and MongoDB\Driver\Manager::attachCursor() errors
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+<?php skip_if_server_version('<', '3.6'); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+echo throws(function() use ($manager) {
+    $manager->executeQuery(NS, new MongoDB\Driver\Query([]))->detach();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($manager) {
+    $session = $manager->startSession();
+    $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]), ['session' => $session])->detach();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($manager) {
+    $manager->attachCursor('invalid');
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$token = $cursor->detach();
+unset($cursor);
+
+echo throws(function() use ($token) {
+    $otherManager = new MongoDB\Driver\Manager(URI, ['appname' => 'cursor-detach_error-001']);
+    $otherManager->attachCursor($token);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+var_dump(count($manager->attachCursor($token)->toArray()));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECTF--
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors that are exhausted cannot be detached
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors using a session cannot be detached
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+No detached cursor exists for token "invalid"
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+The cursor for token "%s" was detached from a different Manager
+int(5)
+===DONE===
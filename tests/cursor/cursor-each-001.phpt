@@ -0,0 +1,55 @@
+--TEST--
+MongoDB\Driver\Cursor::each() invokes a callback for each document
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setTypeMap(['root' => 'array']);
+
+var_dump($cursor->each(function($document, $key) {
+    printf("%d => %s\n", $key, json_encode($document));
+}));
+var_dump($cursor->isDead());
+
+echo "\nReturning false stops iteration:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+
+var_dump($cursor->each(function($document, $key) {
+    printf("%d => %s\n", $key, json_encode($document));
+
+    return $document->_id < 2;
+}));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+0 => {"_id":0}
+1 => {"_id":1}
+2 => {"_id":2}
+3 => {"_id":3}
+4 => {"_id":4}
+int(5)
+bool(true)
+
+Returning false stops iteration:
+0 => {"_id":0}
+1 => {"_id":1}
+2 => {"_id":2}
+int(3)
+===DONE===
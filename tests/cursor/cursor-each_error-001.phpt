@@ -0,0 +1,56 @@
+--TEST--
+MongoDB\Driver\Cursor::each() and map() consume the cursor
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+$bulk->insert(['_id' => 1]);
+$bulk->insert(['_id' => 2]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->each(function() {});
+
+echo throws(function() use ($cursor) {
+    $cursor->map(function() {});
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($cursor) {
+    foreach ($cursor as $document) {}
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 1]));
+$cursor->nextBatch();
+
+echo throws(function() use ($cursor) {
+    $cursor->each(function() {});
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+
+echo throws(function() use ($cursor) {
+    $cursor->each(function($document) {
+        throw new Exception('Callback failed for ' . $document->_id);
+    });
+}, 'Exception'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot be consumed by map() after starting iteration
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot yield multiple iterators
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot be consumed by each() after fetching batches
+OK: Got Exception
+Callback failed for 1
+===DONE===
@@ -0,0 +1,63 @@
+--TEST--
+MongoDB\Driver\Cursor streams batches for an exhaust query
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_mongos(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$query = new MongoDB\Driver\Query([], ['batchSize' => 2, 'exhaust' => true]);
+
+echo "Iterating:\n";
+$cursor = $manager->executeQuery(NS, $query);
+
+foreach ($cursor as $document) {
+    printf("%d\n", $document->_id);
+}
+
+var_dump($cursor->isDead());
+
+echo "\nFetching batches:\n";
+$cursor = $manager->executeQuery(NS, $query);
+$cursor->setTypeMap(['root' => 'array']);
+
+while ($batch = $cursor->nextBatch()) {
+    echo json_encode($batch), "\n";
+}
+
+echo "\nThe client is usable afterwards:\n";
+var_dump(count($manager->executeQuery(NS, new MongoDB\Driver\Query([]))->toArray()));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Iterating:
+0
+1
+2
+3
+4
+bool(true)
+
+Fetching batches:
+[{"_id":0},{"_id":1}]
+[{"_id":2},{"_id":3}]
+[{"_id":4}]
+
+The client is usable afterwards:
+int(5)
+===DONE===
@@ -0,0 +1,73 @@
+--TEST--
+MongoDB\Driver\Cursor::exportJSON() writes extended JSON to a stream
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 3; $i++) {
+    $bulk->insert(['_id' => $i, 'x' => 1.5, 'y' => new MongoDB\BSON\Int64(1)]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$modes = [
+    'Relaxed lines (default)' => [],
+    'Canonical lines' => ['mode' => 'canonical'],
+    'Relaxed array' => ['lines' => false],
+];
+
+foreach ($modes as $description => $options) {
+    echo $description, ":\n";
+
+    $stream = fopen('php://memory', 'w+');
+    $cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+
+    var_dump($cursor->exportJSON($stream, $options));
+    var_dump($cursor->isDead());
+
+    rewind($stream);
+    echo stream_get_contents($stream), "\n";
+    fclose($stream);
+}
+
+echo "Empty array:\n";
+$stream = fopen('php://memory', 'w+');
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query(['_id' => -1]));
+var_dump($cursor->exportJSON($stream, ['lines' => false]));
+rewind($stream);
+echo stream_get_contents($stream), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Relaxed lines (default):
+int(3)
+bool(true)
+{ "_id" : 0, "x" : 1.5, "y" : 1 }
+{ "_id" : 1, "x" : 1.5, "y" : 1 }
+{ "_id" : 2, "x" : 1.5, "y" : 1 }
+
+Canonical lines:
+int(3)
+bool(true)
+{ "_id" : { "$numberInt" : "0" }, "x" : { "$numberDouble" : "1.5" }, "y" : { "$numberLong" : "1" } }
+{ "_id" : { "$numberInt" : "1" }, "x" : { "$numberDouble" : "1.5" }, "y" : { "$numberLong" : "1" } }
+{ "_id" : { "$numberInt" : "2" }, "x" : { "$numberDouble" : "1.5" }, "y" : { "$numberLong" : "1" } }
+
+Relaxed array:
+int(3)
+bool(true)
+[{ "_id" : 0, "x" : 1.5, "y" : 1 },{ "_id" : 1, "x" : 1.5, "y" : 1 },{ "_id" : 2, "x" : 1.5, "y" : 1 }]
+Empty array:
+int(0)
+[]
+===DONE===
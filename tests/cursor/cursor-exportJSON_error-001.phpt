@@ -0,0 +1,45 @@
+--TEST--
+MongoDB\Driver\Cursor::exportJSON() errors
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+$bulk->insert(['_id' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$stream = fopen('php://memory', 'w+');
+
+echo throws(function() use ($manager, $stream) {
+    $manager->executeQuery(NS, new MongoDB\Driver\Query([]))->exportJSON($stream, ['mode' => 'legacy']);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->toArray();
+
+echo throws(function() use ($cursor, $stream) {
+    $cursor->exportJSON($stream);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($manager) {
+    $stream = fopen('php://memory', 'r');
+    $manager->executeQuery(NS, new MongoDB\Driver\Query([]))->exportJSON($stream);
+}, 'MongoDB\Driver\Exception\RuntimeException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected "mode" option to be "canonical" or "relaxed"
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot be consumed by exportJSON() after starting iteration
+OK: Got MongoDB\Driver\Exception\RuntimeException
+Failed to write JSON to stream
+===DONE===
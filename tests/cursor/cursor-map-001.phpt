@@ -0,0 +1,54 @@
+--TEST--
+MongoDB\Driver\Cursor::map() returns the callback's result for each document
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+
+var_dump($cursor->map(function($document, $key) {
+    return $key . ':' . ($document->_id * 10);
+}));
+
+echo "\nDocuments are not recycled:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['limit' => 3]));
+$cursor->setDocumentRecycling(true);
+
+echo json_encode($cursor->map(function($document) {
+    return $document;
+})), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array(5) {
+  [0]=>
+  string(3) "0:0"
+  [1]=>
+  string(4) "1:10"
+  [2]=>
+  string(4) "2:20"
+  [3]=>
+  string(4) "3:30"
+  [4]=>
+  string(4) "4:40"
+}
+
+Documents are not recycled:
+[{"_id":0},{"_id":1},{"_id":2}]
+===DONE===
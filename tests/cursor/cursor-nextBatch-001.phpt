@@ -0,0 +1,51 @@
+--TEST--
+MongoDB\Driver\Cursor::nextBatch() returns documents one server batch at a time
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setTypeMap(['root' => 'array']);
+
+do {
+    $batch = $cursor->nextBatch();
+    echo json_encode($batch), "\n";
+} while ($batch);
+
+var_dump($cursor->isDead());
+
+echo "\nRaw BSON batches:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 3]));
+
+while ($batch = $cursor->nextBatch(true)) {
+    echo implode(' ', array_map('MongoDB\BSON\toJSON', $batch)), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+[{"_id":0},{"_id":1}]
+[{"_id":2},{"_id":3}]
+[{"_id":4}]
+[]
+bool(true)
+
+Raw BSON batches:
+{ "_id" : 0 } { "_id" : 1 } { "_id" : 2 }
+{ "_id" : 3 } { "_id" : 4 }
+===DONE===
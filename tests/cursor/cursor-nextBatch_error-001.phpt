@@ -0,0 +1,40 @@
+--TEST--
+MongoDB\Driver\Cursor::nextBatch() cannot be mixed with iteration
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+
+foreach ($cursor as $document) {}
+
+echo throws(function() use ($cursor) {
+    $cursor->nextBatch();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->nextBatch();
+
+echo throws(function() use ($cursor) {
+    $cursor->toArray();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot fetch batches after starting iteration
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot yield an iterator after fetching batches
+===DONE===
@@ -0,0 +1,80 @@
+--TEST--
+MongoDB\Driver\Cursor::setAdaptiveBatchSize() derives getMore batch sizes from document sizes
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_server_version('<', '3.2'); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+class Test implements MongoDB\Driver\Monitoring\CommandSubscriber
+{
+    public function executeQuery()
+    {
+        $manager = new MongoDB\Driver\Manager(URI);
+
+        /* Each document is 1022 bytes, so a budget of 5000 bytes allows four
+         * documents per batch */
+        $bulk = new MongoDB\Driver\BulkWrite;
+
+        for ($i = 0; $i < 9; $i++) {
+            $bulk->insert(['_id' => $i, 'x' => str_repeat('x', 1000)]);
+        }
+
+        $manager->executeBulkWrite(NS, $bulk);
+
+        MongoDB\Driver\Monitoring\addSubscriber($this);
+
+        $cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+        $cursor->setAdaptiveBatchSize(5000);
+
+        foreach ($cursor as $document) {
+            printf("Iterated document %d\n", $document->_id);
+        }
+
+        MongoDB\Driver\Monitoring\removeSubscriber($this);
+    }
+
+    public function commandStarted(MongoDB\Driver\Monitoring\CommandStartedEvent $event)
+    {
+        $command = $event->getCommand();
+
+        if ($event->getCommandName() === 'find') {
+            printf("find batchSize: %d\n", $command->batchSize);
+        }
+
+        if ($event->getCommandName() === 'getMore') {
+            printf("getMore batchSize: %d\n", $command->batchSize);
+        }
+    }
+
+    public function commandSucceeded(MongoDB\Driver\Monitoring\CommandSucceededEvent $event)
+    {
+    }
+
+    public function commandFailed(MongoDB\Driver\Monitoring\CommandFailedEvent $event)
+    {
+    }
+}
+
+(new Test)->executeQuery();
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+find batchSize: 2
+Iterated document 0
+Iterated document 1
+getMore batchSize: 4
+Iterated document 2
+Iterated document 3
+Iterated document 4
+Iterated document 5
+getMore batchSize: 4
+Iterated document 6
+Iterated document 7
+Iterated document 8
+===DONE===
@@ -0,0 +1,23 @@
+--TEST--
+MongoDB\Driver\Cursor::setAdaptiveBatchSize() rejects invalid byte budgets
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+
+echo throws(function() use ($cursor) {
+    $cursor->setAdaptiveBatchSize(-1);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected target bytes to be >= 0 and <= 2147483647, -1 given
+===DONE===
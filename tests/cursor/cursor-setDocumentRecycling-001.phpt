@@ -0,0 +1,81 @@
+--TEST--
+MongoDB\Driver\Cursor::setDocumentRecycling() overwrites documents of the same shape
+--SKIPIF--
+<?php if (PHP_VERSION_ID < 70000) { die('skip Document recycling requires PHP 7'); } ?>
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1, 'x' => 'a']);
+$bulk->insert(['_id' => 2, 'x' => 'b']);
+$bulk->insert(['_id' => 3, 'y' => 'c']);
+$bulk->insert(['_id' => 4, 'y' => 'd']);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setDocumentRecycling(true);
+
+/* Compare object hashes, since retaining the previous document would prevent
+ * it from being recycled */
+$previous = null;
+
+foreach ($cursor as $document) {
+    echo json_encode($document), ' ';
+    var_dump(spl_object_hash($document) === $previous);
+    $previous = spl_object_hash($document);
+}
+
+echo "\nRecycling does not apply to retained documents:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setDocumentRecycling(true);
+
+$documents = [];
+
+foreach ($cursor as $document) {
+    $documents[] = $document;
+}
+
+echo json_encode($documents), "\n";
+
+echo "\nRecycling does not apply to toArray():\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setDocumentRecycling(true);
+echo json_encode($cursor->toArray()), "\n";
+
+echo "\nRecycling does not apply to arrays:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setTypeMap(['root' => 'array']);
+$cursor->setDocumentRecycling(true);
+
+$documents = [];
+
+foreach ($cursor as $document) {
+    $documents[] = $document;
+}
+
+echo json_encode($documents), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+{"_id":1,"x":"a"} bool(false)
+{"_id":2,"x":"b"} bool(true)
+{"_id":3,"y":"c"} bool(false)
+{"_id":4,"y":"d"} bool(true)
+
+Recycling does not apply to retained documents:
+[{"_id":1,"x":"a"},{"_id":2,"x":"b"},{"_id":3,"y":"c"},{"_id":4,"y":"d"}]
+
+Recycling does not apply to toArray():
+[{"_id":1,"x":"a"},{"_id":2,"x":"b"},{"_id":3,"y":"c"},{"_id":4,"y":"d"}]
+
+Recycling does not apply to arrays:
+[{"_id":1,"x":"a"},{"_id":2,"x":"b"},{"_id":3,"y":"c"},{"_id":4,"y":"d"}]
+===DONE===
@@ -0,0 +1,49 @@
+--TEST--
+MongoDB\Driver\Cursor::setDocumentRecycling() does not decode documents of a different shape twice
+--SKIPIF--
+<?php if (PHP_VERSION_ID < 70000) { die('skip Document recycling requires PHP 7'); } ?>
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+class MyDocument implements MongoDB\BSON\Unserializable
+{
+    public function bsonUnserialize(array $data)
+    {
+        printf("bsonUnserialize(%s)\n", json_encode($data));
+    }
+}
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1, 'x' => ['a' => 1]]);
+$bulk->insert(['_id' => 2, 'x' => ['a' => 2]]);
+$bulk->insert(['_id' => 3, 'x' => ['a' => 3], 'y' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setTypeMap(['fieldPaths' => ['x' => 'MyDocument']]);
+$cursor->setDocumentRecycling(true);
+
+$previous = null;
+
+foreach ($cursor as $document) {
+    var_dump(spl_object_hash($document) === $previous);
+    $previous = spl_object_hash($document);
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bsonUnserialize({"a":1})
+bool(false)
+bsonUnserialize({"a":2})
+bool(true)
+bsonUnserialize({"a":3})
+bool(false)
+===DONE===
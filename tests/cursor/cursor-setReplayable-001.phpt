@@ -0,0 +1,67 @@
+--TEST--
+MongoDB\Driver\Cursor::setReplayable() allows a cursor to be rewound and iterated again
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+
+for ($i = 0; $i < 4; $i++) {
+    $bulk->insert(['_id' => $i]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setReplayable(true);
+
+echo "Partial iteration:\n";
+foreach ($cursor as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+
+    if ($key === 1) {
+        break;
+    }
+}
+
+echo "\nReplayed iteration continues past the consumed documents:\n";
+foreach ($cursor as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+}
+
+echo "\nReplay with a different type map:\n";
+$cursor->setTypeMap(['root' => 'array']);
+var_dump(array_map('is_array', $cursor->toArray()));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+Partial iteration:
+0 => {"_id":0}
+1 => {"_id":1}
+
+Replayed iteration continues past the consumed documents:
+0 => {"_id":0}
+1 => {"_id":1}
+2 => {"_id":2}
+3 => {"_id":3}
+
+Replay with a different type map:
+array(4) {
+  [0]=>
+  bool(true)
+  [1]=>
+  bool(true)
+  [2]=>
+  bool(true)
+  [3]=>
+  bool(true)
+}
+===DONE===
@@ -0,0 +1,39 @@
+--TEST--
+MongoDB\Driver\Cursor::setReplayable() must be called before iteration
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+$bulk->insert(['_id' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->toArray();
+
+echo throws(function() use ($cursor) {
+    $cursor->setReplayable(true);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setReplayable(true);
+
+echo throws(function() use ($cursor) {
+    $cursor->nextBatch();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot change replay mode after starting iteration
+OK: Got MongoDB\Driver\Exception\LogicException
+Replayable cursors cannot fetch batches
+===DONE===
@@ -0,0 +1,75 @@
+--TEST--
+MongoDB\Driver\Cursor::toColumns() returns per-field arrays
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1, 'price' => 1.5, 'qty' => 10, 'meta' => ['sku' => 'a'], 'tags' => ['x']]);
+$bulk->insert(['_id' => 2, 'price' => 2.25, 'meta' => ['sku' => 'b'], 'tags' => []]);
+$bulk->insert(['_id' => 3, 'price' => 3.0, 'qty' => 30, 'meta' => ['sku' => 'c'], 'tags' => ['y', 'z']]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setTypeMap(['array' => 'array']);
+
+var_dump($cursor->toColumns(['price', 'qty', 'meta.sku', 'tags', 'price']));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+array(4) {
+  ["price"]=>
+  array(3) {
+    [0]=>
+    float(1.5)
+    [1]=>
+    float(2.25)
+    [2]=>
+    float(3)
+  }
+  ["qty"]=>
+  array(3) {
+    [0]=>
+    int(10)
+    [1]=>
+    NULL
+    [2]=>
+    int(30)
+  }
+  ["meta.sku"]=>
+  array(3) {
+    [0]=>
+    string(1) "a"
+    [1]=>
+    string(1) "b"
+    [2]=>
+    string(1) "c"
+  }
+  ["tags"]=>
+  array(3) {
+    [0]=>
+    array(1) {
+      [0]=>
+      string(1) "x"
+    }
+    [1]=>
+    array(0) {
+    }
+    [2]=>
+    array(2) {
+      [0]=>
+      string(1) "y"
+      [1]=>
+      string(1) "z"
+    }
+  }
+}
+===DONE===
@@ -0,0 +1,43 @@
+--TEST--
+MongoDB\Driver\Cursor::toColumns() requires string field paths and an unused cursor
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite();
+$bulk->insert(['_id' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+
+echo throws(function() use ($cursor) {
+    $cursor->toColumns(['_id', 1]);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+$cursor->toColumns(['_id']);
+
+echo throws(function() use ($cursor) {
+    $cursor->toColumns(['_id']);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($cursor) {
+    foreach ($cursor as $document) {}
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected field path to be a string, integer given
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot be consumed by toColumns() after starting iteration
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot yield multiple iterators
+===DONE===
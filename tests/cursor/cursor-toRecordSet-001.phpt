@@ -0,0 +1,89 @@
+--TEST--
+MongoDB\Driver\Cursor::toRecordSet() returns a lazily decoded RecordSet
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+
+for ($i = 0; $i < 5; $i++) {
+    $bulk->insert(['_id' => $i, 'x' => ['y' => $i * 2]]);
+}
+
+$manager->executeBulkWrite(NS, $bulk);
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([], ['batchSize' => 2]));
+$cursor->setTypeMap(['root' => 'array', 'document' => 'array']);
+
+$recordSet = $cursor->toRecordSet(2);
+
+var_dump($recordSet instanceof Countable);
+var_dump($recordSet instanceof ArrayAccess);
+var_dump($recordSet instanceof Traversable);
+var_dump(count($recordSet));
+var_dump(isset($recordSet[4]), isset($recordSet['4']), isset($recordSet[5]), isset($recordSet[-1]));
+
+echo "\nRandom access uses the cursor's type map:\n";
+echo json_encode($recordSet[3]), "\n";
+echo json_encode($recordSet[3]), "\n";
+echo json_encode($recordSet[1]), "\n";
+
+echo "\nIteration:\n";
+foreach ($recordSet as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+}
+
+echo "\nIterating again:\n";
+foreach ($recordSet as $key => $document) {
+    printf("%d => %s\n", $key, json_encode($document));
+}
+
+echo "\nEmpty result:\n";
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query(['_id' => -1]));
+$recordSet = $cursor->toRecordSet();
+var_dump(count($recordSet));
+var_dump(iterator_to_array($recordSet));
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+int(5)
+bool(true)
+bool(true)
+bool(false)
+bool(false)
+
+Random access uses the cursor's type map:
+{"_id":3,"x":{"y":6}}
+{"_id":3,"x":{"y":6}}
+{"_id":1,"x":{"y":2}}
+
+Iteration:
+0 => {"_id":0,"x":{"y":0}}
+1 => {"_id":1,"x":{"y":2}}
+2 => {"_id":2,"x":{"y":4}}
+3 => {"_id":3,"x":{"y":6}}
+4 => {"_id":4,"x":{"y":8}}
+
+Iterating again:
+0 => {"_id":0,"x":{"y":0}}
+1 => {"_id":1,"x":{"y":2}}
+2 => {"_id":2,"x":{"y":4}}
+3 => {"_id":3,"x":{"y":6}}
+4 => {"_id":4,"x":{"y":8}}
+
+Empty result:
+int(0)
+array(0) {
+}
+===DONE===
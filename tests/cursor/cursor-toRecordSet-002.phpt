@@ -0,0 +1,62 @@
+--TEST--
+MongoDB\Driver\Cursor::toRecordSet(): Modifying a row does not affect later reads
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+$bulk->insert(['_id' => 1, 'x' => ['y' => 1]]);
+$manager->executeBulkWrite(NS, $bulk);
+
+$typeMaps = [
+    'objects' => [],
+    'arrays' => ['root' => 'array', 'document' => 'array'],
+    'array with embedded objects' => ['root' => 'array'],
+];
+
+foreach ($typeMaps as $name => $typeMap) {
+    echo $name, ":\n";
+
+    $cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+    $cursor->setTypeMap($typeMap);
+    $recordSet = $cursor->toRecordSet(1);
+
+    $row = $recordSet[0];
+
+    if (is_array($row)) {
+        $row['_id'] = 2;
+
+        if (is_array($row['x'])) {
+            $row['x']['y'] = 2;
+        } else {
+            $row['x']->y = 2;
+        }
+    } else {
+        $row->_id = 2;
+        $row->x->y = 2;
+    }
+
+    echo json_encode($row), "\n";
+    echo json_encode($recordSet[0]), "\n";
+}
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+objects:
+{"_id":2,"x":{"y":2}}
+{"_id":1,"x":{"y":1}}
+arrays:
+{"_id":2,"x":{"y":2}}
+{"_id":1,"x":{"y":1}}
+array with embedded objects:
+{"_id":2,"x":{"y":2}}
+{"_id":1,"x":{"y":1}}
+===DONE===
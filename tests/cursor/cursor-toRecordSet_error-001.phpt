@@ -0,0 +1,71 @@
+--TEST--
+MongoDB\Driver\Cursor::toRecordSet() and MongoDB\Driver\RecordSet errors
+--SKIPIF--
+<?php require __DIR__ . "/../utils/basic-skipif.inc"; ?>
+<?php skip_if_not_live(); ?>
+<?php skip_if_not_clean(); ?>
+--FILE--
+<?php
+require_once __DIR__ . "/../utils/basic.inc";
+
+$manager = new MongoDB\Driver\Manager(URI);
+
+$bulk = new MongoDB\Driver\BulkWrite;
+$bulk->insert(['_id' => 1]);
+$manager->executeBulkWrite(NS, $bulk);
+
+echo throws(function() use ($manager) {
+    $manager->executeQuery(NS, new MongoDB\Driver\Query([]))->toRecordSet(-1);
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->toArray();
+
+echo throws(function() use ($cursor) {
+    $cursor->toRecordSet();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$cursor = $manager->executeQuery(NS, new MongoDB\Driver\Query([]));
+$cursor->setReplayable(true);
+
+echo throws(function() use ($cursor) {
+    $cursor->toRecordSet();
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+$recordSet = $manager->executeQuery(NS, new MongoDB\Driver\Query([]))->toRecordSet();
+
+echo throws(function() use ($recordSet) {
+    $recordSet[1];
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() use ($recordSet) {
+    $recordSet['foo'];
+}, 'MongoDB\Driver\Exception\InvalidArgumentException'), "\n";
+
+echo throws(function() use ($recordSet) {
+    $recordSet[0] = [];
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+echo throws(function() use ($recordSet) {
+    unset($recordSet[0]);
+}, 'MongoDB\Driver\Exception\LogicException'), "\n";
+
+?>
+===DONE===
+<?php exit(0); ?>
+--EXPECT--
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected cache size to be >= 0, -1 given
+OK: Got MongoDB\Driver\Exception\LogicException
+Cursors cannot be consumed by toRecordSet() after starting iteration
+OK: Got MongoDB\Driver\Exception\LogicException
+Replayable cursors cannot be converted to a RecordSet
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Offset 1 is out of range
+OK: Got MongoDB\Driver\Exception\InvalidArgumentException
+Expected offset to be an integer, string given
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\Driver\RecordSet is immutable
+OK: Got MongoDB\Driver\Exception\LogicException
+MongoDB\Driver\RecordSet is immutable
+===DONE===